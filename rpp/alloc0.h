@@ -11,6 +11,24 @@ namespace rpp {
 void sys_free(void* mem) noexcept;
 [[nodiscard]] i64 sys_net_allocs() noexcept;
 
+// Like realloc: may extend in place or, for large blocks, remap pages instead of copying.
+[[nodiscard]] void* sys_realloc(void* mem, u64 size) noexcept;
+
+// Alignment must be a power of two. Freed with sys_free_aligned.
+[[nodiscard]] void* sys_alloc_aligned(u64 size, u64 alignment) noexcept;
+void sys_free_aligned(void* mem) noexcept;
+
+// Allocations of at least a huge page are aligned to one and hinted to be backed by transparent
+// huge pages where the platform supports it. Freed with sys_free.
+[[nodiscard]] void* sys_alloc_huge(u64 size) noexcept;
+
+// Virtual memory: reserve address space, then commit and decommit page-aligned ranges within it.
+[[nodiscard]] u64 sys_page_size() noexcept;
+[[nodiscard]] void* sys_reserve(u64 size) noexcept;
+void sys_commit(void* mem, u64 size) noexcept;
+void sys_decommit(void* mem, u64 size) noexcept;
+void sys_release(void* mem, u64 size) noexcept;
+
 template<typename A>
 concept Allocator = requires(u64 size, void* address) {
     Same<Literal, decltype(A::name)>;
@@ -18,6 +36,66 @@ concept Allocator = requires(u64 size, void* address) {
     { A::free(address) } -> Same<void>;
 };
 
+// Allocators that can provide more than the default alignment themselves.
+template<typename A>
+concept Aligned_Allocator = Allocator<A> && requires(u64 size, u64 alignment, void* address) {
+    { A::alloc_aligned(size, alignment) } -> Same<void*>;
+    { A::free_aligned(address) } -> Same<void>;
+};
+
+// Allocators that can resize a block, preserving its contents, without always copying.
+template<typename A>
+concept Reallocating_Allocator = Allocator<A> && requires(u64 size, void* address) {
+    { A::realloc(address, size) } -> Same<void*>;
+};
+
+// Every allocator returns at least this alignment.
+constexpr u64 DEFAULT_ALIGNMENT = 16;
+
+// Allocates from A with the given alignment. Over-aligned requests use A's own support if it
+// has any, and otherwise over-allocate and store the original pointer just before the block.
+template<Allocator A, u64 Align>
+struct Aligned_Adaptor {
+    static_assert(Align > 0 && (Align & (Align - 1)) == 0);
+
+    constexpr static Literal name = A::name;
+
+    [[nodiscard]] static void* alloc(u64 size) noexcept {
+        if constexpr(Align <= DEFAULT_ALIGNMENT) {
+            return A::alloc(size);
+        } else if constexpr(Aligned_Allocator<A>) {
+            return A::alloc_aligned(size, Align);
+        } else {
+            if(!size) return null;
+            u8* base = reinterpret_cast<u8*>(A::alloc(size + Align + sizeof(void*)));
+            u8* aligned = reinterpret_cast<u8*>(
+                Math::align_pow2(reinterpret_cast<uptr>(base) + sizeof(void*), Align));
+            Libc::memcpy(aligned - sizeof(void*), &base, sizeof(void*));
+            return aligned;
+        }
+    }
+
+    // Over-aligned blocks would lose their alignment, so only plain blocks are resized.
+    [[nodiscard]] static void* realloc(void* mem, u64 size) noexcept
+        requires(Align <= DEFAULT_ALIGNMENT) && Reallocating_Allocator<A>
+    {
+        return A::realloc(mem, size);
+    }
+
+    static void free(void* mem) noexcept {
+        if constexpr(Align <= DEFAULT_ALIGNMENT) {
+            A::free(mem);
+        } else if constexpr(Aligned_Allocator<A>) {
+            A::free_aligned(mem);
+        } else {
+            if(!mem) return;
+            void* base = null;
+            Libc::memcpy(&base, reinterpret_cast<u8*>(mem) - sizeof(void*), sizeof(void*));
+            A::free(base);
+        }
+    }
+};
+
 template<typename A>
 concept Pool = requires(Empty<> t) { // Can't express forall types T
     { A::template make<Empty<>>(t) } -> Same<Empty<>*>;
@@ -34,7 +112,7 @@ struct Scalar_Adaptor {
     template<typename T, typename... Args>
         requires Allocator<A> && Constructable<T, Args...>
     [[nodiscard]] static T* make(Args&&... args) noexcept {
-        T* mem = reinterpret_cast<T*>(A::alloc(sizeof(T)));
+        T* mem = reinterpret_cast<T*>(Aligned_Adaptor<A, alignof(T)>::alloc(sizeof(T)));
         new(mem) T{forward<Args>(args)...};
         return mem;
     }
@@ -45,7 +123,7 @@ struct Scalar_Adaptor {
         if constexpr(Must_Destruct<T>) {
             mem->~T();
         }
-        A::free(mem);
+        Aligned_Adaptor<A, alignof(T)>::free(mem);
     }
 };
 
@@ -54,11 +132,17 @@ struct Scalar_Adaptor {
 template<typename P>
 using Pool_Adaptor = If<Allocator<P>, detail::Scalar_Adaptor<P>, P>;
 
-template<Literal N, bool Log = true>
+// With Huge set, allocations of at least a huge page are backed by huge pages where available.
+// Huge allocators don't reallocate: the system realloc would drop the alignment and the hint.
+template<Literal N, bool Log = true, bool Huge = false>
 struct Mallocator {
     constexpr static Literal name = N;
     static void* alloc(u64 size) noexcept;
+    static void* realloc(void* mem, u64 size) noexcept
+        requires(!Huge);
     static void free(void* mem) noexcept;
+    static void* alloc_aligned(u64 size, u64 alignment) noexcept;
+    static void free_aligned(void* mem) noexcept;
 };
 
 using Region = u64;
@@ -86,6 +170,7 @@ struct Region_Allocator {
 
     static u64 depth() noexcept;
     static u64 size() noexcept;
+    static u64 high_water() noexcept;
 
 private:
     static void begin(Region region) noexcept;
@@ -88,23 +88,61 @@ struct Mpool {
     }
 };
 
-template<Literal N, bool log>
-[[nodiscard]] void* Mallocator<N, log>::alloc(u64 size) noexcept {
+template<Literal N, bool log, bool huge>
+[[nodiscard]] void* Mallocator<N, log, huge>::alloc(u64 size) noexcept {
     if(!size) return null;
-    void* ret = sys_alloc(size);
+    void* ret = huge ? sys_alloc_huge(size) : sys_alloc(size);
     if constexpr(log) {
-        Profile::alloc({String_View{N}, ret, size});
+        Profile::alloc({Intern::get<N>(), ret, size});
     }
     return ret;
 }
 
-template<Literal N, bool log>
-void Mallocator<N, log>::free(void* mem) noexcept {
+template<Literal N, bool log, bool huge>
+[[nodiscard]] void* Mallocator<N, log, huge>::realloc(void* mem, u64 size) noexcept
+    requires(!huge)
+{
+    if(!mem) return alloc(size);
+    if(!size) {
+        free(mem);
+        return null;
+    }
+    if constexpr(log) {
+        Profile::alloc({Intern::get<N>(), mem, 0});
+    }
+    void* ret = sys_realloc(mem, size);
+    if constexpr(log) {
+        Profile::alloc({Intern::get<N>(), ret, size});
+    }
+    return ret;
+}
+
+template<Literal N, bool log, bool huge>
+void Mallocator<N, log, huge>::free(void* mem) noexcept {
     if(!mem) return;
     if constexpr(log) {
-        Profile::alloc({String_View{N}, mem, 0});
+        Profile::alloc({Intern::get<N>(), mem, 0});
     }
     sys_free(mem);
 }
 
+template<Literal N, bool log, bool huge>
+[[nodiscard]] void* Mallocator<N, log, huge>::alloc_aligned(u64 size, u64 alignment) noexcept {
+    if(!size) return null;
+    void* ret = sys_alloc_aligned(size, alignment);
+    if constexpr(log) {
+        Profile::alloc({Intern::get<N>(), ret, size});
+    }
+    return ret;
+}
+
+template<Literal N, bool log, bool huge>
+void Mallocator<N, log, huge>::free_aligned(void* mem) noexcept {
+    if(!mem) return;
+    if constexpr(log) {
+        Profile::alloc({Intern::get<N>(), mem, 0});
+    }
+    sys_free_aligned(mem);
+}
+
 } // namespace rpp
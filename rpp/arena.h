@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include "base.h"
+
+namespace rpp {
+
+namespace detail {
+struct Arena_Chunk;
+}
+
+// Bump allocator that, unlike the thread-local region stack, is an object that can be shared
+// between threads. Any thread may allocate from it concurrently; everything is released at
+// once by reset or destruction. Chunks come from a process-wide cache, so resetting and
+// recreating arenas per request doesn't touch malloc in the steady state.
+struct Arena {
+    Arena() noexcept = default;
+    ~Arena() noexcept;
+
+    Arena(const Arena&) noexcept = delete;
+    Arena& operator=(const Arena&) noexcept = delete;
+
+    Arena(Arena&&) noexcept = delete;
+    Arena& operator=(Arena&&) noexcept = delete;
+
+    // Binds an arena as the calling thread's allocator for Marena until the scope ends. Scopes
+    // nest. Must not be held across a co_await: the coroutine may resume on another thread.
+    struct Scope {
+        explicit Scope(Arena& arena) noexcept : prev{current_} {
+            current_ = &arena;
+        }
+        ~Scope() noexcept {
+            current_ = prev;
+        }
+
+        Scope(const Scope&) noexcept = delete;
+        Scope& operator=(const Scope&) noexcept = delete;
+
+        Scope(Scope&&) noexcept = delete;
+        Scope& operator=(Scope&&) noexcept = delete;
+
+    private:
+        Arena* prev = null;
+    };
+
+    // Thread safe. Returns 16-byte aligned memory.
+    [[nodiscard]] void* alloc(u64 size) noexcept;
+
+    // Frees every allocation. Must not run concurrently with alloc.
+    void reset() noexcept;
+
+    // Bytes allocated since the last reset.
+    [[nodiscard]] u64 size() const noexcept {
+        return allocated.load(Thread::Order::relaxed);
+    }
+
+    [[nodiscard]] static Arena* current() noexcept {
+        return current_;
+    }
+
+private:
+    using Chunk = detail::Arena_Chunk;
+
+    [[nodiscard]] void* alloc_large(u64 size) noexcept;
+    void grow(Chunk* full) noexcept;
+
+    Thread::Atomic<Chunk*> chunk;
+    Thread::Atomic<u64> allocated;
+
+    Thread::Mutex mutex;
+    // Filled chunks, followed by dedicated chunks for large allocations.
+    Chunk* full = null;
+    Chunk* large = null;
+
+    static inline thread_local Arena* current_ = null;
+};
+
+// Allocates from the calling thread's current Arena. Freeing is a no-op, so memory may be
+// freed from any thread.
+struct Marena {
+    constexpr static Literal name = "Arena";
+    [[nodiscard]] static void* alloc(u64 size) noexcept {
+        Arena* arena = Arena::current();
+        assert(arena);
+        return arena->alloc(size);
+    }
+    static void free(void*) noexcept {
+    }
+};
+
+} // namespace rpp
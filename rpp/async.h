@@ -42,10 +42,63 @@ struct Promise;
 template<typename R = void, Allocator A = Alloc>
 struct Task;
 
+template<bool Any, typename Nodes>
+struct When;
+
 constexpr i64 TASK_START = 0;
 constexpr i64 TASK_DONE = 1;
 constexpr i64 TASK_ABANDONED = 2;
 
+// Tag bit marking a continuation that is a When_Node rather than a coroutine address.
+constexpr i64 TASK_WHEN = 1;
+
+namespace detail {
+
+struct When_State;
+
+struct When_Node {
+    When_State* when = null;
+    Thread::Atomic<i64>* state = null;
+    u64 index = 0;
+};
+
+// Shared completion state for when_all and when_any. Each finished child decrements remaining
+// (for when_any, only the first one), and whoever brings it to zero resumes the parent. The
+// parent holds one extra count while it is still attaching to the children.
+struct When_State {
+    explicit When_State(bool any) noexcept : any{any} {
+    }
+
+    [[nodiscard]] static bool is_node(i64 state) noexcept {
+        return state > TASK_ABANDONED && (state & TASK_WHEN);
+    }
+    [[nodiscard]] static When_Node* to_node(i64 state) noexcept {
+        return reinterpret_cast<When_Node*>(state & ~TASK_WHEN);
+    }
+    [[nodiscard]] static i64 of_node(When_Node& node) noexcept {
+        return reinterpret_cast<i64>(&node) | TASK_WHEN;
+    }
+
+    [[nodiscard]] std::coroutine_handle<> finish(u64 index) noexcept {
+        std::coroutine_handle<> continuation = parent;
+        bool counts = !any || winner.compare_and_swap(-1, static_cast<i64>(index)) == -1;
+        // Losers of when_any may not touch this object after dropping their reference.
+        attached.decr(Thread::Order::release);
+        if(counts && remaining.decr() == 0) {
+            return continuation;
+        }
+        return std::noop_coroutine();
+    }
+
+    std::coroutine_handle<> parent;
+    Thread::Atomic<i64> remaining;
+    Thread::Atomic<i64> attached;
+    Thread::Atomic<i64> winner{-1};
+    bool any = false;
+};
+
+} // namespace detail
+
 struct Final_Suspend {
     [[nodiscard]] bool await_ready() noexcept {
         return false;
@@ -59,10 +112,14 @@ struct Final_Suspend {
     template<typename R, Allocator A>
     void await_suspend(std::coroutine_handle<Promise<R, A>> handle) noexcept {
 
-        i64 state = handle.promise().state.exchange(TASK_DONE);
+        // Releases the result to the continuation and acquires the continuation's frame.
+        i64 state = handle.promise().state.exchange(TASK_DONE, Thread::Order::acq_rel);
 
         if(state == TASK_ABANDONED) {
             handle.destroy();
+        } else if(detail::When_State::is_node(state)) {
+            detail::When_Node* node = detail::When_State::to_node(state);
+            node->when->finish(node->index).resume();
         } else if(state != TASK_START) {
             // Can stack overflow
             std::coroutine_handle<>::from_address(reinterpret_cast<void*>(state)).resume();
@@ -73,10 +130,14 @@ struct Final_Suspend {
     [[nodiscard]] std::coroutine_handle<>
     await_suspend(std::coroutine_handle<Promise<R, A>> handle) noexcept {
 
-        i64 state = handle.promise().state.exchange(TASK_DONE);
+        // Releases the result to the continuation and acquires the continuation's frame.
+        i64 state = handle.promise().state.exchange(TASK_DONE, Thread::Order::acq_rel);
 
         if(state == TASK_ABANDONED) {
             handle.destroy();
+        } else if(detail::When_State::is_node(state)) {
+            detail::When_Node* node = detail::When_State::to_node(state);
+            return node->when->finish(node->index);
         } else if(state != TASK_START) {
             return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(state));
         }
@@ -120,7 +181,7 @@ struct Promise_Base {
     }
 
 protected:
-    Thread::Atomic state{TASK_START};
+    Thread::Atomic<i64> state{TASK_START};
     Thread::Flag flag;
 
     friend struct Task<R, A>;
@@ -159,7 +220,8 @@ struct Task {
     }
 
     ~Task() noexcept {
-        if(handle && handle.promise().state.exchange(TASK_ABANDONED) == TASK_DONE) {
+        if(handle && handle.promise().state.exchange(TASK_ABANDONED, Thread::Order::acq_rel) ==
+                         TASK_DONE) {
             handle.destroy();
         }
     }
@@ -179,11 +241,12 @@ struct Task {
     }
 
     [[nodiscard]] bool await_ready() noexcept {
-        return handle.promise().state.load() == TASK_DONE;
+        return handle.promise().state.load(Thread::Order::acquire) == TASK_DONE;
     }
     [[nodiscard]] bool await_suspend(std::coroutine_handle<> continuation) noexcept {
         i64 cont = reinterpret_cast<i64>(continuation.address());
-        return handle.promise().state.compare_and_swap(TASK_START, cont) == TASK_START;
+        return handle.promise().state.compare_and_swap(TASK_START, cont, Thread::Order::acq_rel) ==
+               TASK_START;
     }
     [[nodiscard]] R await_resume() noexcept {
         if constexpr(Same<R, void>) {
@@ -208,7 +271,15 @@ struct Task {
     }
 
 private:
+    [[nodiscard]] detail::When_Node when_node() noexcept {
+        assert(handle);
+        return detail::When_Node{null, &handle.promise().state, 0};
+    }
+
     std::coroutine_handle<Promise<R, A>> handle;
+
+    template<bool, typename>
+    friend struct When;
 };
 
 template<Allocator A>
@@ -221,9 +292,138 @@ struct Promise<void, A> : Promise_Base<void, A> {
     }
 };
 
+template<bool Any, typename Nodes>
+struct When {
+
+    explicit When(Nodes nodes) noexcept : nodes{move(nodes)} {
+    }
+    ~When() noexcept = default;
+
+    When(const When&) noexcept = delete;
+    When& operator=(const When&) noexcept = delete;
+
+    When(When&&) noexcept = default;
+    When& operator=(When&&) noexcept = default;
+
+    [[nodiscard]] bool await_ready() noexcept {
+        if constexpr(Any) {
+            assert(nodes.length() > 0);
+            return false;
+        } else {
+            return nodes.length() == 0;
+        }
+    }
+
+    [[nodiscard]] bool await_suspend(std::coroutine_handle<> parent) noexcept {
+        u64 n = nodes.length();
+        state.parent = parent;
+        state.remaining.store(Any ? 2 : static_cast<i64>(n) + 1, Thread::Order::relaxed);
+        state.attached.store(static_cast<i64>(n), Thread::Order::relaxed);
+
+        for(u64 i = 0; i < n; i++) {
+            detail::When_Node& node = nodes[i];
+            node.when = &state;
+            node.index = i;
+            i64 tagged = detail::When_State::of_node(node);
+            if(node.state->compare_and_swap(TASK_START, tagged) != TASK_START) {
+                // Already done: we still hold the parent's count, so this never resumes it.
+                static_cast<void>(state.finish(i));
+            }
+        }
+
+        return state.remaining.decr() != 0;
+    }
+
+    auto await_resume() noexcept {
+        if constexpr(Any) {
+            // Children that lost the race still reference our state, so detach them before
+            // it goes away. The rest are about to drop their reference in When_State::finish.
+            for(auto& node : nodes) {
+                i64 tagged = detail::When_State::of_node(node);
+                if(node.state->compare_and_swap(tagged, TASK_START) == tagged) {
+                    state.attached.decr();
+                }
+            }
+            while(state.attached.load(Thread::Order::acquire) != 0) {
+                Thread::pause();
+            }
+            return static_cast<u64>(state.winner.load());
+        }
+    }
+
+    template<typename... Rs, Allocator... As>
+    [[nodiscard]] static When make(Task<Rs, As>&... tasks) noexcept {
+        return When{Nodes{tasks.when_node()...}};
+    }
+
+    template<typename R, Allocator TA, Allocator VA>
+    [[nodiscard]] static When make(Vec<Task<R, TA>, VA>& tasks) noexcept {
+        Nodes nodes(tasks.length());
+        for(auto& task : tasks) {
+            nodes.push(task.when_node());
+        }
+        return When{move(nodes)};
+    }
+
+private:
+    Nodes nodes;
+    detail::When_State state{Any};
+};
+
+// Suspends until every task has finished, resuming the caller exactly once. The tasks remain
+// owned by the caller; awaiting them afterwards returns their results without suspending.
+template<typename... Rs, Allocator... As>
+    requires(sizeof...(Rs) > 0)
+[[nodiscard]] auto when_all(Task<Rs, As>&... tasks) noexcept {
+    using Nodes = Array<detail::When_Node, sizeof...(Rs)>;
+    return When<false, Nodes>::make(tasks...);
+}
+
+template<typename R, Allocator TA, Allocator VA>
+[[nodiscard]] auto when_all(Vec<Task<R, TA>, VA>& tasks) noexcept {
+    using Nodes = Vec<detail::When_Node, VA>;
+    return When<false, Nodes>::make(tasks);
+}
+
+// Suspends until any task has finished and returns its index. The remaining tasks keep running
+// and may be awaited (or dropped) as usual.
+template<typename... Rs, Allocator... As>
+    requires(sizeof...(Rs) > 0)
+[[nodiscard]] auto when_any(Task<Rs, As>&... tasks) noexcept {
+    using Nodes = Array<detail::When_Node, sizeof...(Rs)>;
+    return When<true, Nodes>::make(tasks...);
+}
+
+template<typename R, Allocator TA, Allocator VA>
+[[nodiscard]] auto when_any(Vec<Task<R, TA>, VA>& tasks) noexcept {
+    using Nodes = Vec<detail::When_Node, VA>;
+    return When<true, Nodes>::make(tasks);
+}
+
+namespace detail {
+
+// Node of a user-space Event's waiter stack. It lives in the awaiter, and enqueue resumes a batch
+// of handles on the pool it was created for.
+struct Event_Waiter {
+    std::coroutine_handle<> handle;
+    void* pool = null;
+    void (*enqueue)(void* pool, Slice<Handle<>> jobs, Thread::Priority priority) = null;
+    Thread::Priority priority = Thread::Priority::normal;
+    Event_Waiter* next = null;
+};
+
+} // namespace detail
+
+// Manual-reset event. A default constructed event lives in user space: waiting coroutines push
+// themselves onto a lock-free stack and signal resumes them on their pools, without any kernel
+// object or syscall. Await one with Pool::wait.
+//
+// make_sys and of_sys instead wrap a kernel object the pool's event thread can wait on: an
+// eventfd or epoll source on Linux, and an event handle on Windows. Await those with Pool::event,
+// which takes ownership. Only kernel events can be passed to wait_any.
 struct Event {
 
-    Event() noexcept;
+    Event() noexcept = default;
     ~Event() noexcept;
 
     Event(const Event&) noexcept = delete;
@@ -234,17 +434,36 @@ struct Event {
 
     [[nodiscard]] static u64 wait_any(Slice<Event> events) noexcept;
 
-    void signal() const noexcept;
-    void reset() const noexcept;
+    void signal() noexcept;
+    void reset() noexcept;
     [[nodiscard]] bool try_wait() const noexcept;
 
+    [[nodiscard]] static Event make_sys() noexcept;
 #ifdef RPP_OS_WINDOWS
     [[nodiscard]] static Event of_sys(void* event) noexcept;
+
+    [[nodiscard]] bool is_sys() const noexcept {
+        return event_ != null;
+    }
 #else
     [[nodiscard]] static Event of_sys(i32 fd, i32 mask) noexcept;
+
+    [[nodiscard]] bool is_sys() const noexcept {
+        return fd != -1;
+    }
 #endif
 
 private:
+    // Zero when unsignalled with no waiters, SIGNALED once set, and otherwise the most recent
+    // waiter. Unused by kernel events.
+    constexpr static uptr SIGNALED = 1;
+
+    void signal_sys() noexcept;
+    void reset_sys() noexcept;
+    [[nodiscard]] bool try_wait_sys() const noexcept;
+    void close_sys() noexcept;
+
+    Thread::Atomic<uptr> state;
 #ifdef RPP_OS_WINDOWS
     Event(void* event) noexcept : event_{event} {
     }
@@ -255,6 +474,9 @@ private:
     i32 fd = -1;
     i32 mask = 0;
 #endif
+
+    template<Allocator>
+    friend struct Wait_Event;
 };
 
 } // namespace rpp::Async
@@ -10,6 +10,7 @@
 #define RPP_COMPILER_MSVC
 #define RPP_FORCE_INLINE __forceinline
 #define RPP_MSVC_INTRINSIC [[msvc::intrinsic]]
+#include <intrin0.h>
 #include <vcruntime_new.h>
 
 // TODO(max): bump when they fix the coroutine bug
@@ -105,6 +106,7 @@ namespace Libc {
 [[nodiscard]] u64 strlen(const char* str) noexcept;
 void* memset(void* dest, i32 value, u64 bytes) noexcept;
 void* memcpy(void* dest, const void* src, u64 bytes) noexcept;
+void* memmove(void* dest, const void* src, u64 bytes) noexcept;
 [[nodiscard]] i32 memcmp(const void* a, const void* b, u64 bytes) noexcept;
 [[nodiscard]] i32 snprintf(u8* buffer, u64 buffer_size, const char* fmt, ...) noexcept;
 [[nodiscard]] i64 strtoll(const char* str, char** endptr, i32 base) noexcept;
@@ -136,6 +138,8 @@ void* memcpy(void* dest, const void* src, u64 bytes) noexcept;
 
 #include "thread0.h"
 
+#include "format0.h"
+
 #include "log.h"
 
 #include "format.h"
@@ -158,6 +162,8 @@ void* memcpy(void* dest, const void* src, u64 bytes) noexcept;
 
 #include "string1.h"
 
+#include "intern.h"
+
 #include "function.h"
 
 #include "profile.h"
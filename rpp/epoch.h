@@ -0,0 +1,58 @@
+
+#pragma once
+
+#include "base.h"
+
+// Epoch-based memory reclamation for lock-free data structures.
+//
+// Readers enter a Guard before loading shared pointers and leave it when done with them.
+// Writers unlink an object so new readers can't reach it, then retire it. A retired object is
+// destroyed once every thread that might have observed it has left its guard, which is
+// detected by advancing a global epoch that pinned threads hold back.
+
+namespace rpp::Epoch {
+
+using Alloc = Mallocator<"Epoch">;
+
+// Pin and unpin the calling thread. Calls nest. Threads register on first use and unregister
+// at exit, handing any remaining retired objects to whoever collects next.
+void enter() noexcept;
+void exit() noexcept;
+
+// Schedules destroy(ptr) for when no guard that could have observed ptr is still active.
+void retire(void* ptr, void (*destroy)(void*)) noexcept;
+
+// Tries to advance the epoch, then destroys this thread's retired objects that are now safe.
+// retire calls this periodically; Async::Pool workers also call it before parking.
+void collect() noexcept;
+
+// Objects retired by this thread and not yet destroyed.
+[[nodiscard]] u64 pending() noexcept;
+
+// Blocks until everything retired by this thread, or handed off by exited threads, is
+// destroyed. The calling thread must not be pinned, and others must eventually unpin.
+void synchronize() noexcept;
+
+// Must not be held across a co_await: the coroutine may resume on another thread.
+struct Guard {
+    Guard() noexcept {
+        enter();
+    }
+    ~Guard() noexcept {
+        exit();
+    }
+
+    Guard(const Guard&) noexcept = delete;
+    Guard& operator=(const Guard&) noexcept = delete;
+
+    Guard(Guard&&) noexcept = delete;
+    Guard& operator=(Guard&&) noexcept = delete;
+};
+
+template<typename T, Scalar_Allocator P = Mdefault>
+void retire(T* ptr) noexcept {
+    retire(static_cast<void*>(ptr),
+           [](void* p) { Pool_Adaptor<P>::template destroy<T>(static_cast<T*>(p)); });
+}
+
+} // namespace rpp::Epoch
@@ -7,6 +7,91 @@
 
 namespace rpp {
 
+// Appends text into a fixed buffer, usually on the caller's stack. When the buffer fills up,
+// the contents move to storage from A, which grows by doubling. Unlike format, appending does
+// not measure arguments up front.
+template<Allocator A = Mdefault>
+struct String_Builder {
+
+    String_Builder() noexcept = default;
+    String_Builder(u8* buffer, u64 capacity) noexcept : data_(buffer), capacity_(capacity) {
+    }
+    template<u64 N>
+    explicit String_Builder(u8 (&buffer)[N]) noexcept : String_Builder(buffer, N) {
+    }
+
+    ~String_Builder() noexcept {
+        if(owned_) A::free(data_);
+        data_ = null;
+        length_ = 0;
+        capacity_ = 0;
+        owned_ = false;
+    }
+
+    String_Builder(const String_Builder&) noexcept = delete;
+    String_Builder& operator=(const String_Builder&) noexcept = delete;
+
+    String_Builder(String_Builder&&) noexcept = delete;
+    String_Builder& operator=(String_Builder&&) noexcept = delete;
+
+    // Returns space for at least n more bytes. Call commit with the number actually written.
+    [[nodiscard]] u8* reserve(u64 n) noexcept {
+        if(length_ + n > capacity_) grow(length_ + n);
+        return data_ + length_;
+    }
+    void commit(u64 n) noexcept {
+        assert(length_ + n <= capacity_);
+        length_ += n;
+    }
+
+    void append(char c) noexcept {
+        *reserve(1) = static_cast<u8>(c);
+        length_++;
+    }
+    void append(String_View text) noexcept {
+        Libc::memcpy(reserve(text.length()), text.data(), text.length());
+        length_ += text.length();
+    }
+
+    void clear() noexcept {
+        length_ = 0;
+    }
+
+    [[nodiscard]] u64 length() const noexcept {
+        return length_;
+    }
+    [[nodiscard]] u64 capacity() const noexcept {
+        return capacity_;
+    }
+    [[nodiscard]] bool spilled() const noexcept {
+        return owned_;
+    }
+
+    [[nodiscard]] String_View view() const noexcept {
+        return String_View{data_, length_};
+    }
+    template<Allocator B = A>
+    [[nodiscard]] String<B> string() const noexcept {
+        return view().template string<B>();
+    }
+
+private:
+    void grow(u64 min) noexcept {
+        u64 capacity = Math::max(Math::max(capacity_ * 2, min), u64{64});
+        u8* data = reinterpret_cast<u8*>(A::alloc(capacity));
+        if(length_) Libc::memcpy(data, data_, length_);
+        if(owned_) A::free(data_);
+        data_ = data;
+        capacity_ = capacity;
+        owned_ = true;
+    }
+
+    u8* data_ = null;
+    u64 length_ = 0;
+    u64 capacity_ = 0;
+    bool owned_ = false;
+};
+
 namespace Format {
 
 using namespace Reflect;
@@ -17,6 +102,9 @@ struct Measure;
 template<Allocator A, Reflectable T>
 struct Write;
 
+template<Reflectable T>
+struct Append;
+
 template<Allocator A, Reflectable T>
 [[nodiscard]] u64 snprintf(String<A>& output, u64 idx, const char* fmt, const T& value) noexcept {
     Region(R) {
@@ -190,6 +278,94 @@ struct Write {
     }
 };
 
+template<Allocator A>
+void append_unsigned(String_Builder<A>& output, u64 value) noexcept {
+    u8 digits[20];
+    u64 n = 0;
+    do {
+        digits[n++] = static_cast<u8>('0' + value % 10);
+        value /= 10;
+    } while(value);
+    u8* out = output.reserve(n);
+    for(u64 i = 0; i < n; i++) out[i] = digits[n - i - 1];
+    output.commit(n);
+}
+
+template<Allocator A>
+void append_signed(String_Builder<A>& output, i64 value) noexcept {
+    if(value < 0) {
+        output.append('-');
+        append_unsigned(output, u64{0} - static_cast<u64>(value));
+    } else {
+        append_unsigned(output, static_cast<u64>(value));
+    }
+}
+
+// Formats directly into the builder, retrying only if the guess was too small.
+template<Allocator A, typename T>
+void append_snprintf(String_Builder<A>& output, const char* fmt, const T& value) noexcept {
+    constexpr u64 guess = 32;
+    i32 length = Libc::snprintf(output.reserve(guess), guess, fmt, value);
+    assert(length >= 0);
+    u64 n = static_cast<u64>(length);
+    if(n >= guess) {
+        assert(Libc::snprintf(output.reserve(n + 1), n + 1, fmt, value) == length);
+    }
+    output.commit(n);
+}
+
+template<Reflectable T>
+struct Append {
+    template<Allocator A>
+    static void append(String_Builder<A>& output, const T& value) noexcept {
+        using R = Refl<T>;
+
+        if constexpr(R::kind == Kind::void_) {
+            output.append("void"_v);
+        } else if constexpr(R::kind == Kind::char_) {
+            output.append(value);
+        } else if constexpr(R::kind == Kind::i8_ || R::kind == Kind::i16_ ||
+                            R::kind == Kind::i32_ || R::kind == Kind::i64_) {
+            append_signed(output, static_cast<i64>(value));
+        } else if constexpr(R::kind == Kind::u8_ || R::kind == Kind::u16_ ||
+                            R::kind == Kind::u32_ || R::kind == Kind::u64_) {
+            append_unsigned(output, static_cast<u64>(value));
+        } else if constexpr(R::kind == Kind::f32_ || R::kind == Kind::f64_) {
+            append_snprintf(output, "%f", value);
+        } else if constexpr(R::kind == Kind::bool_) {
+            output.append(value ? "true"_v : "false"_v);
+        } else if constexpr(R::kind == Kind::array_) {
+            output.append('[');
+            for(u64 i = 0; i < R::length; i++) {
+                Append<typename R::underlying>::append(output, value[i]);
+                if(i + 1 < R::length) output.append(", "_v);
+            }
+            output.append(']');
+        } else if constexpr(R::kind == Kind::pointer_) {
+            if(value == null) {
+                output.append("(null)"_v);
+            } else {
+                output.append('(');
+                append_snprintf(output, "%p", value);
+                output.append(')');
+            }
+        } else if constexpr(R::kind == Kind::enum_) {
+            output.append(String_View{R::name});
+            output.append("::"_v);
+            iterate_enum<T>([&](const Literal& name, T check) {
+                if(value == check) output.append(String_View{name});
+            });
+        } else {
+            // Records may specialize Write, so they are measured and written as usual.
+            u64 length = Measure<T>::measure(value);
+            String<A> buffer{length};
+            buffer.set_length(length);
+            assert((Write<A, T>::write(buffer, 0, value) == length));
+            output.append(buffer.view());
+        }
+    }
+};
+
 template<Allocator A, typename... Ts>
     requires(Reflectable<Ts> && ...)
 [[nodiscard]] u64 write(String_View fmt, u64 fmt_idx, String<A>& output, u64 output_idx,
@@ -277,6 +453,85 @@ template<Allocator A, typename... Ts>
     return output;
 }
 
+namespace Format {
+
+// Appends fmt from idx up to the next argument, returning the index of its '%'.
+template<Allocator A>
+[[nodiscard]] u64 append_literal(String_Builder<A>& output, String_View fmt, u64 idx) noexcept {
+    u64 start = idx;
+    for(; idx < fmt.length(); idx++) {
+        if(fmt[idx] != '%') continue;
+        if(idx + 1 < fmt.length() && fmt[idx + 1] == '%') {
+            output.append(fmt.sub(start, idx + 1));
+            start = ++idx + 1;
+            continue;
+        }
+        break;
+    }
+    output.append(fmt.sub(start, idx));
+    return idx;
+}
+
+} // namespace Format
+
+// Appends the formatted text to output in a single pass and returns everything in output.
+template<Allocator A, typename... Ts>
+    requires(Reflectable<Ts> && ...)
+String_View format_to(String_Builder<A>& output, String_View fmt, const Ts&... args) noexcept {
+    u64 idx = 0;
+    ((idx = Format::append_literal(output, fmt, idx), assert(idx < fmt.length()),
+      Format::Append<Ts>::append(output, args), idx++),
+     ...);
+    idx = Format::append_literal(output, fmt, idx);
+    assert(idx == fmt.length());
+    return output.view();
+}
+
+namespace Format {
+
+template<Static_String F, Allocator A, typename... Ts, u64... Is>
+[[nodiscard]] u64 write_static(String<A>& output, Index_Sequence<Is...>,
+                               const Ts&... args) noexcept {
+    using S = Static_Format<F>;
+    u64 idx = 0;
+    ((idx = output.write(idx, S::template segment<Is>()),
+      idx = Write<A, Ts>::write(output, idx, args)),
+     ...);
+    return output.write(idx, S::template segment<sizeof...(Ts)>());
+}
+
+template<Static_String F, Allocator A, typename... Ts, u64... Is>
+void append_static(String_Builder<A>& output, Index_Sequence<Is...>, const Ts&... args) noexcept {
+    using S = Static_Format<F>;
+    ((output.append(S::template segment<Is>()), Append<Ts>::append(output, args)), ...);
+    output.append(S::template segment<sizeof...(Ts)>());
+}
+
+} // namespace Format
+
+template<Allocator A, Format::Static_String F, typename... Ts>
+    requires(Reflectable<Ts> && ...)
+[[nodiscard]] String<A> format(Format::Static_Format<F>, const Ts&... args) noexcept {
+    static_assert(Format::Static_Format<F>::arguments == sizeof...(Ts),
+                  "Format argument count does not match the format string.");
+    u64 length = Format::Static_Format<F>::length + (Format::Measure<Ts>::measure(args) + ... + 0);
+    String<A> output{length};
+    output.set_length(length);
+    u64 idx = Format::write_static<F>(output, Make_Index_Sequence<sizeof...(Ts)>{}, args...);
+    assert(idx == length);
+    return output;
+}
+
+template<Allocator A, Format::Static_String F, typename... Ts>
+    requires(Reflectable<Ts> && ...)
+String_View format_to(String_Builder<A>& output, Format::Static_Format<F>,
+                      const Ts&... args) noexcept {
+    static_assert(Format::Static_Format<F>::arguments == sizeof...(Ts),
+                  "Format argument count does not match the format string.");
+    Format::append_static<F>(output, Make_Index_Sequence<sizeof...(Ts)>{}, args...);
+    return output.view();
+}
+
 template<typename T>
 concept Writable = requires(String<> s) {
     { s.write(0, T{}) } -> Same<u64>;
@@ -378,6 +633,17 @@ struct Typename<T<T0, N>> {
     }
 };
 
+template<template<typename, u64, typename> typename T, Reflectable T0, u64 N,
+         Scalar_Allocator A0>
+    requires Reflectable<T<T0, N, A0>>
+struct Typename<T<T0, N, A0>> {
+    template<Allocator A>
+    [[nodiscard]] static String<A> name() noexcept {
+        return format<A>("%<%, %>"_v, String_View{Refl<T<T0, N, A0>>::name},
+                         Typename<T0>::template name<A>(), N);
+    }
+};
+
 template<template<typename, typename> typename T, Reflectable T0, typename T1>
     requires(Reflectable<T<T0, T1>> && !Allocator<T1>)
 struct Typename<T<T0, T1>> {
@@ -395,4 +661,27 @@ template<Reflectable T, Allocator A = Mdefault>
     return Format::Typename<Decay<T>>::template name<A>();
 }
 
+namespace Log {
+
+template<typename... Ts>
+void log(Level level, const Location& loc, String_View fmt, const Ts&... args) noexcept {
+    u8 buffer[LOG_BUFFER_SIZE];
+    Region(R) {
+        String_Builder<Mregion<R>> message{buffer};
+        output(level, move(loc), format_to(message, fmt, args...));
+    }
+}
+
+template<Format::Static_String F, typename... Ts>
+void log(Level level, const Location& loc, Format::Static_Format<F> fmt,
+         const Ts&... args) noexcept {
+    u8 buffer[LOG_BUFFER_SIZE];
+    Region(R) {
+        String_Builder<Mregion<R>> message{buffer};
+        output(level, move(loc), format_to(message, fmt, args...));
+    }
+}
+
+} // namespace Log
+
 } // namespace rpp
@@ -0,0 +1,93 @@
+
+#pragma once
+
+#ifndef RPP_BASE
+#error "Include base.h instead."
+#endif
+
+// Format strings parsed at compile time. "x = %"_f splits the literal into the text between
+// placeholders, so formatting with it checks the argument count at build time and writes each
+// segment directly instead of scanning for '%' on every call.
+
+namespace rpp::Format {
+
+template<u64 N>
+struct Static_String {
+    constexpr static u64 capacity = N;
+
+    consteval Static_String(const char (&literal)[N]) noexcept {
+        for(u64 i = 0; i < N; i++) c_string[i] = literal[i];
+    }
+
+    char c_string[N] = {};
+};
+
+template<u64 N, u64 S>
+struct Static_Segments {
+    // The literal with "%%" unescaped. Segment i is text[ends[i - 1], ends[i]).
+    u8 text[N] = {};
+    u64 ends[S] = {};
+};
+
+template<u64 N>
+[[nodiscard]] consteval u64 static_arguments(const char (&fmt)[N]) noexcept {
+    u64 args = 0;
+    for(u64 i = 0; i + 1 < N; i++) {
+        if(fmt[i] != '%') continue;
+        if(i + 2 < N && fmt[i + 1] == '%') {
+            i++;
+        } else {
+            args++;
+        }
+    }
+    return args;
+}
+
+template<u64 S, u64 N>
+[[nodiscard]] consteval Static_Segments<N, S> static_segments(const char (&fmt)[N]) noexcept {
+    Static_Segments<N, S> segments;
+    u64 length = 0;
+    u64 segment = 0;
+    for(u64 i = 0; i + 1 < N; i++) {
+        if(fmt[i] == '%') {
+            if(i + 2 < N && fmt[i + 1] == '%') {
+                segments.text[length++] = '%';
+                i++;
+            } else {
+                segments.ends[segment++] = length;
+            }
+            continue;
+        }
+        segments.text[length++] = static_cast<u8>(fmt[i]);
+    }
+    segments.ends[segment] = length;
+    return segments;
+}
+
+template<Static_String F>
+struct Static_Format {
+    constexpr static u64 arguments = static_arguments(F.c_string);
+    constexpr static Static_Segments<F.capacity, arguments + 1> segments =
+        static_segments<arguments + 1>(F.c_string);
+
+    // Total length of the text outside of placeholders.
+    constexpr static u64 length = segments.ends[arguments];
+
+    template<u64 I>
+    [[nodiscard]] static String_View segment() noexcept {
+        static_assert(I <= arguments);
+        constexpr u64 begin = I == 0 ? 0 : segments.ends[I - 1];
+        return String_View{segments.text + begin, segments.ends[I] - begin};
+    }
+
+    [[nodiscard]] static String_View view() noexcept {
+        return String_View{reinterpret_cast<const u8*>(F.c_string), F.capacity - 1};
+    }
+};
+
+} // namespace rpp::Format
+
+template<rpp::Format::Static_String F>
+[[nodiscard]] consteval rpp::Format::Static_Format<F> operator""_f() noexcept {
+    return {};
+}
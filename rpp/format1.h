@@ -51,16 +51,13 @@ template<Enum E>
     while(start < s.length() && ascii::is_whitespace(s[start])) {
         start++;
     }
-    for(u64 i = start; i < s.length(); i++) {
-        if((i + 1 == s.length() && start < i)) {
-            return Opt<Pair<String_View, String_View>>{Pair{s.sub(start, i + 1), String_View{}}};
-        }
-        if(ascii::is_whitespace(s[i])) {
-            return Opt<Pair<String_View, String_View>>{
-                Pair{s.sub(start, i), s.sub(i + 1, s.length())}};
-        }
+    String_View rest = s.sub(start, s.length());
+    if(rest.empty()) return {};
+    if(Opt<u64> end = rest.find_any(" \t\n\r\v"_v)) {
+        return Opt<Pair<String_View, String_View>>{
+            Pair{rest.sub(0, *end), rest.sub(*end + 1, rest.length())}};
     }
-    return {};
+    return Opt<Pair<String_View, String_View>>{Pair{rest, String_View{}}};
 }
 
 template<Enum E>
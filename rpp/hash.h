@@ -34,6 +34,102 @@ namespace Hash {
     return squirrel5(h1 + h2);
 }
 
+namespace detail {
+
+// Folded 64x64 -> 128 bit multiply.
+constexpr void mum(u64& a, u64& b) noexcept {
+#ifdef RPP_COMPILER_MSVC
+    u64 a_lo = a & 0xffffffff, a_hi = a >> 32;
+    u64 b_lo = b & 0xffffffff, b_hi = b >> 32;
+    u64 lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    u64 cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    a = (cross << 32) | (lo_lo & 0xffffffff);
+    b = hi_hi + (hi_lo >> 32) + (cross >> 32);
+#else
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    a = static_cast<u64>(r);
+    b = static_cast<u64>(r >> 64);
+#endif
+}
+
+[[nodiscard]] constexpr u64 mix(u64 a, u64 b) noexcept {
+    mum(a, b);
+    return a ^ b;
+}
+
+// Little-endian loads that also work in constant evaluation. Compilers fold them into a single
+// unaligned load.
+template<typename C>
+[[nodiscard]] constexpr u64 read8(const C* p) noexcept {
+    u64 v = 0;
+    for(u64 i = 0; i < 8; i++) v |= static_cast<u64>(static_cast<u8>(p[i])) << (8 * i);
+    return v;
+}
+template<typename C>
+[[nodiscard]] constexpr u64 read4(const C* p) noexcept {
+    u64 v = 0;
+    for(u64 i = 0; i < 4; i++) v |= static_cast<u64>(static_cast<u8>(p[i])) << (8 * i);
+    return v;
+}
+template<typename C>
+[[nodiscard]] constexpr u64 read3(const C* p, u64 length) noexcept {
+    return (static_cast<u64>(static_cast<u8>(p[0])) << 16) |
+           (static_cast<u64>(static_cast<u8>(p[length >> 1])) << 8) |
+           static_cast<u64>(static_cast<u8>(p[length - 1]));
+}
+
+} // namespace detail
+
+// Hashes a byte string 16 to 48 bytes at a time (wyhash). Usable at compile time, so string
+// literals hash to the same values as their runtime copies.
+template<typename C>
+    requires(sizeof(C) == 1)
+[[nodiscard]] constexpr u64 bytes(const C* data, u64 length, u64 seed = 0) noexcept {
+    constexpr u64 P0 = 0xa0761d6478bd642full;
+    constexpr u64 P1 = 0xe7037ed1a0b428dbull;
+    constexpr u64 P2 = 0x8ebc6af09c88c6e3ull;
+    constexpr u64 P3 = 0x589965cc75374cc3ull;
+
+    const C* p = data;
+    u64 a = 0, b = 0;
+    seed ^= detail::mix(seed ^ P0, P1);
+
+    if(length <= 16) {
+        if(length >= 4) {
+            u64 skip = (length >> 3) << 2;
+            a = (detail::read4(p) << 32) | detail::read4(p + skip);
+            b = (detail::read4(p + length - 4) << 32) | detail::read4(p + length - 4 - skip);
+        } else if(length > 0) {
+            a = detail::read3(p, length);
+        }
+    } else {
+        u64 i = length;
+        if(i > 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = detail::mix(detail::read8(p) ^ P1, detail::read8(p + 8) ^ seed);
+                see1 = detail::mix(detail::read8(p + 16) ^ P2, detail::read8(p + 24) ^ see1);
+                see2 = detail::mix(detail::read8(p + 32) ^ P3, detail::read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while(i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while(i > 16) {
+            seed = detail::mix(detail::read8(p) ^ P1, detail::read8(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = detail::read8(p + i - 16);
+        b = detail::read8(p + i - 8);
+    }
+
+    a ^= P1;
+    b ^= seed;
+    detail::mum(a, b);
+    return detail::mix(a ^ P0 ^ length, b ^ P1);
+}
+
 template<typename K>
 struct Hash;
 
@@ -96,10 +192,8 @@ template<Hashable... Ts>
 
 template<size_t N>
 [[nodiscard]] consteval u64 hash_literal(const char (&literal)[N], u64 seed = 0) noexcept {
-    for(size_t i = 0; i < N - 1; i++) {
-        seed = Hash::hash_combine(seed, hash(literal[i]));
-    }
-    return seed ? seed : 1;
+    u64 h = Hash::bytes(literal, N - 1, seed);
+    return h ? h : 1;
 }
 
 } // namespace rpp
@@ -11,7 +11,7 @@ struct Heap {
     Heap() noexcept = default;
 
     explicit Heap(u64 capacity) noexcept {
-        data_ = reinterpret_cast<T*>(A::alloc(capacity * sizeof(T)));
+        data_ = reinterpret_cast<T*>(Backing::alloc(capacity * sizeof(T)));
         length_ = 0;
         capacity_ = capacity;
     }
@@ -51,7 +51,7 @@ struct Heap {
                 v.~T();
             }
         }
-        A::free(data_);
+        Backing::free(data_);
         data_ = null;
         length_ = 0;
         capacity_ = 0;
@@ -85,7 +85,15 @@ struct Heap {
     {
         if(new_capacity <= capacity_) return;
 
-        T* new_data = reinterpret_cast<T*>(A::alloc(new_capacity * sizeof(T)));
+        if constexpr(Trivially_Movable<T> && Reallocating_Allocator<Backing>) {
+            if(data_) {
+                data_ = reinterpret_cast<T*>(Backing::realloc(data_, new_capacity * sizeof(T)));
+                capacity_ = new_capacity;
+                return;
+            }
+        }
+
+        T* new_data = reinterpret_cast<T*>(Backing::alloc(new_capacity * sizeof(T)));
         if constexpr(Trivially_Movable<T>) {
             Libc::memcpy(new_data, data_, length_ * sizeof(T));
         } else {
@@ -94,7 +102,7 @@ struct Heap {
                 new(&new_data[i]) T{move(data_[i])};
             }
         }
-        A::free(data_);
+        Backing::free(data_);
 
         capacity_ = new_capacity;
         data_ = new_data;
@@ -185,6 +193,8 @@ struct Heap {
     }
 
 private:
+    using Backing = Aligned_Adaptor<A, alignof(T)>;
+
     void swap(u64 a, u64 b) noexcept
         requires Move_Constructable<T>
     {
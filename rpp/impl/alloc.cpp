@@ -4,41 +4,74 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef RPP_OS_WINDOWS
+#include <malloc.h>
+#endif
+
 namespace rpp {
 
-static Thread::Atomic g_net_allocs;
+static Thread::Atomic<i64> g_net_allocs;
 
-using Regions = Mallocator<"Regions", false>;
+// Each thread reserves one contiguous range for its regions, so allocation is a pointer bump.
+// Pages are committed as the stack grows and decommitted once it has shrunk well below them,
+// so alternating deep and shallow scopes don't repeatedly map and unmap the same pages.
+constexpr u64 REGION_RESERVE = Math::GB(16);
+constexpr u64 REGION_COMMIT_GRANULE = Math::KB(64);
+constexpr u64 REGION_DECOMMIT_THRESHOLD = Math::MB(4);
+constexpr u64 REGION_RETAIN = Math::MB(1);
+constexpr u64 MAX_REGION_DEPTH = 128;
 
-struct Chunk {
-    Chunk* up = null;
-    u64 size = 0;
-    u64 used = 0;
-};
-static_assert(sizeof(Chunk) == 24);
+struct Region_Memory {
+    Region_Memory() noexcept = default;
+    ~Region_Memory() noexcept {
+        if(base) sys_release(base, REGION_RESERVE);
+        base = null;
+        committed = 0;
+        destroyed = true;
+    }
 
-constexpr u64 FIRST_CHUNK_SIZE = Math::KB(1);
-constexpr u64 MAX_REGION_DEPTH = 128;
+    Region_Memory(const Region_Memory&) noexcept = delete;
+    Region_Memory& operator=(const Region_Memory&) noexcept = delete;
+
+    Region_Memory(Region_Memory&&) noexcept = delete;
+    Region_Memory& operator=(Region_Memory&&) noexcept = delete;
 
-struct First_Chunk {
-    Chunk chunk = {null, FIRST_CHUNK_SIZE - sizeof(Chunk), 0};
-    u8 data[FIRST_CHUNK_SIZE - sizeof(Chunk)] = {};
+    u8* base = null;
+    u64 committed = 0;
+    u64 high_water = 0;
+    // Set once the thread's destructors have run. Another thread_local destructor that uses a
+    // region afterwards must not reserve a range that nothing would release.
+    bool destroyed = false;
 };
-static_assert(sizeof(First_Chunk) == FIRST_CHUNK_SIZE);
 
 thread_local u64 current_region = 0;
 thread_local u64 region_offsets[MAX_REGION_DEPTH] = {};
 thread_local Region region_brands[MAX_REGION_DEPTH] = {};
-thread_local First_Chunk first_chunk;
-thread_local Chunk* chunks = &first_chunk.chunk;
+thread_local Region_Memory region_memory;
+
+static void region_commit(u64 end) noexcept {
+    Region_Memory& memory = region_memory;
+    if(memory.destroyed) {
+        die("Region used after this thread's region memory was destroyed.");
+    }
+    if(!memory.base) {
+        assert(REGION_COMMIT_GRANULE % sys_page_size() == 0);
+        memory.base = reinterpret_cast<u8*>(sys_reserve(REGION_RESERVE));
+    }
+    if(end > REGION_RESERVE) {
+        die("Region stack exceeded its % byte reservation.", REGION_RESERVE);
+    }
+    u64 target = Math::align(end, REGION_COMMIT_GRANULE);
+    sys_commit(memory.base + memory.committed, target - memory.committed);
+    memory.committed = target;
+}
 
-static void new_chunk(u64 request) noexcept {
-    u64 size = Math::max(request + sizeof(Chunk), 2 * (chunks->size + sizeof(Chunk)));
-    Chunk* chunk = reinterpret_cast<Chunk*>(Regions::alloc(size));
-    chunk->size = size - sizeof(Chunk);
-    chunk->used = 0;
-    chunk->up = chunks;
-    chunks = chunk;
+static void region_decommit(u64 end) noexcept {
+    Region_Memory& memory = region_memory;
+    if(memory.committed <= end + REGION_DECOMMIT_THRESHOLD) return;
+    u64 target = Math::align(end + REGION_RETAIN, REGION_COMMIT_GRANULE);
+    sys_decommit(memory.base + target, memory.committed - target);
+    memory.committed = target;
 }
 
 static void assert_brand(Region brand) noexcept {
@@ -49,13 +82,14 @@ static void assert_brand(Region brand) noexcept {
 
 [[nodiscard]] void* Region_Allocator::alloc(Region brand, u64 size) noexcept {
     assert_brand(brand);
-    if(chunks->size - chunks->used < size) {
-        new_chunk(size);
+    u64 offset = region_offsets[current_region];
+    u64 end = offset + size;
+    if(end > region_memory.committed) {
+        region_commit(end);
     }
-    u8* ret = reinterpret_cast<u8*>(chunks) + sizeof(Chunk) + chunks->used;
-    chunks->used += size;
-    region_offsets[current_region] += size;
-    return ret;
+    region_offsets[current_region] = end;
+    region_memory.high_water = Math::max(region_memory.high_water, end);
+    return region_memory.base + offset;
 }
 
 void Region_Allocator::free(Region brand, void*) noexcept {
@@ -72,22 +106,8 @@ void Region_Allocator::begin(Region brand) noexcept {
 void Region_Allocator::end(Region brand) noexcept {
     assert(current_region > 0);
     assert_brand(brand);
-    u64 end_offset = region_offsets[current_region];
     current_region--;
-    u64 start_offset = region_offsets[current_region];
-    u64 free_size = end_offset - start_offset;
-    while(free_size > chunks->used) {
-        free_size -= chunks->used;
-        Chunk* chunk = chunks;
-        chunks = chunks->up;
-        Regions::free(chunk);
-    }
-    chunks->used -= free_size;
-    if(chunks->used == 0 && chunks->up != null) {
-        Chunk* chunk = chunks;
-        chunks = chunks->up;
-        Regions::free(chunk);
-    }
+    region_decommit(region_offsets[current_region]);
 }
 
 [[nodiscard]] u64 Region_Allocator::depth() noexcept {
@@ -98,11 +118,15 @@ void Region_Allocator::end(Region brand) noexcept {
     return region_offsets[current_region];
 }
 
+[[nodiscard]] u64 Region_Allocator::high_water() noexcept {
+    return region_memory.high_water;
+}
+
 [[nodiscard]] void* sys_alloc(u64 sz) noexcept {
     void* ret = malloc(sz);
     assert(ret);
 #ifndef RPP_RELEASE_BUILD
-    g_net_allocs.incr();
+    g_net_allocs.incr(Thread::Order::relaxed);
 #endif
     return ret;
 }
@@ -110,11 +134,45 @@ void Region_Allocator::end(Region brand) noexcept {
 void sys_free(void* mem) noexcept {
     if(!mem) return;
 #ifndef RPP_RELEASE_BUILD
-    g_net_allocs.decr();
+    g_net_allocs.decr(Thread::Order::relaxed);
 #endif
     free(mem);
 }
 
+[[nodiscard]] void* sys_realloc(void* mem, u64 sz) noexcept {
+    assert(mem && sz);
+    // glibc moves large blocks with mremap, so growing them copies no data.
+    void* ret = realloc(mem, sz);
+    assert(ret);
+    return ret;
+}
+
+[[nodiscard]] void* sys_alloc_aligned(u64 sz, u64 alignment) noexcept {
+#ifdef RPP_OS_WINDOWS
+    void* ret = _aligned_malloc(sz, alignment);
+#else
+    void* ret = null;
+    if(posix_memalign(&ret, Math::max(alignment, static_cast<u64>(sizeof(void*))), sz)) ret = null;
+#endif
+    assert(ret);
+#ifndef RPP_RELEASE_BUILD
+    g_net_allocs.incr(Thread::Order::relaxed);
+#endif
+    return ret;
+}
+
+void sys_free_aligned(void* mem) noexcept {
+    if(!mem) return;
+#ifndef RPP_RELEASE_BUILD
+    g_net_allocs.decr(Thread::Order::relaxed);
+#endif
+#ifdef RPP_OS_WINDOWS
+    _aligned_free(mem);
+#else
+    free(mem);
+#endif
+}
+
 [[nodiscard]] i64 sys_net_allocs() noexcept {
     return g_net_allocs.load();
 }
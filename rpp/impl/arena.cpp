@@ -0,0 +1,150 @@
+
+#include "../arena.h"
+
+namespace rpp {
+
+using Arena_Backing = Mallocator<"Arena">;
+
+constexpr u64 ARENA_CHUNK_SIZE = Math::KB(64);
+constexpr u64 ARENA_MAX_CACHED = 64;
+
+namespace detail {
+
+struct Arena_Chunk {
+    Arena_Chunk* next = null;
+    u64 size = 0;
+    Thread::Atomic<u64> used;
+    u64 padding = 0;
+
+    [[nodiscard]] u8* data() noexcept {
+        return reinterpret_cast<u8*>(this + 1);
+    }
+};
+static_assert(sizeof(Arena_Chunk) % 16 == 0);
+
+} // namespace detail
+
+using Arena_Chunk = detail::Arena_Chunk;
+
+// Requests larger than this get a dedicated chunk, so they neither waste the rest of the
+// current chunk nor force it to be replaced.
+constexpr u64 ARENA_LARGE_SIZE = (ARENA_CHUNK_SIZE - sizeof(Arena_Chunk)) / 4;
+
+static Thread::Mutex g_arena_cache_lock;
+static Arena_Chunk* g_arena_cache = null;
+static u64 g_arena_cached = 0;
+static bool g_arena_finalizer_registered = false;
+
+static void free_chunks(Arena_Chunk* chunk) noexcept {
+    while(chunk) {
+        Arena_Chunk* next = chunk->next;
+        chunk->~Arena_Chunk();
+        Arena_Backing::free(chunk);
+        chunk = next;
+    }
+}
+
+[[nodiscard]] static Arena_Chunk* make_chunk(u64 size) noexcept {
+    Arena_Chunk* chunk = new(Arena_Backing::alloc(sizeof(Arena_Chunk) + size)) Arena_Chunk{};
+    chunk->size = size;
+    return chunk;
+}
+
+[[nodiscard]] static Arena_Chunk* take_chunk() noexcept {
+    {
+        Thread::Lock lock(g_arena_cache_lock);
+        if(!g_arena_finalizer_registered) {
+            g_arena_finalizer_registered = true;
+            Profile::finalizer([]() {
+                Thread::Lock lock(g_arena_cache_lock);
+                free_chunks(g_arena_cache);
+                g_arena_cache = null;
+                g_arena_cached = 0;
+            });
+        }
+        if(Arena_Chunk* chunk = g_arena_cache) {
+            g_arena_cache = chunk->next;
+            g_arena_cached--;
+            chunk->next = null;
+            chunk->used.store(0, Thread::Order::relaxed);
+            return chunk;
+        }
+    }
+    return make_chunk(ARENA_CHUNK_SIZE - sizeof(Arena_Chunk));
+}
+
+static void return_chunks(Arena_Chunk* chunk) noexcept {
+    Arena_Chunk* excess = null;
+    {
+        Thread::Lock lock(g_arena_cache_lock);
+        while(chunk) {
+            Arena_Chunk* next = chunk->next;
+            if(g_arena_cached < ARENA_MAX_CACHED) {
+                chunk->next = g_arena_cache;
+                g_arena_cache = chunk;
+                g_arena_cached++;
+            } else {
+                chunk->next = excess;
+                excess = chunk;
+            }
+            chunk = next;
+        }
+    }
+    free_chunks(excess);
+}
+
+Arena::~Arena() noexcept {
+    reset();
+    return_chunks(chunk.exchange(null));
+}
+
+[[nodiscard]] void* Arena::alloc(u64 size) noexcept {
+    size = Math::align(Math::max(size, static_cast<u64>(1)), static_cast<u64>(16));
+    allocated.fetch_add(size, Thread::Order::relaxed);
+
+    if(size > ARENA_LARGE_SIZE) return alloc_large(size);
+
+    for(;;) {
+        Chunk* current = chunk.load(Thread::Order::acquire);
+        if(current) {
+            u64 offset = current->used.fetch_add(size, Thread::Order::relaxed);
+            if(offset + size <= current->size) return current->data() + offset;
+        }
+        grow(current);
+    }
+}
+
+[[nodiscard]] void* Arena::alloc_large(u64 size) noexcept {
+    Chunk* dedicated = make_chunk(size);
+    Thread::Lock lock(mutex);
+    dedicated->next = large;
+    large = dedicated;
+    return dedicated->data();
+}
+
+void Arena::grow(Chunk* current) noexcept {
+    Thread::Lock lock(mutex);
+    // Another thread may have replaced the chunk while we waited.
+    if(chunk.load(Thread::Order::relaxed) != current) return;
+    if(current) {
+        current->next = full;
+        full = current;
+    }
+    chunk.store(take_chunk(), Thread::Order::release);
+}
+
+void Arena::reset() noexcept {
+    Thread::Lock lock(mutex);
+
+    // Keep the current chunk, so a reused arena needs no cache round trip.
+    if(Chunk* current = chunk.load(Thread::Order::relaxed)) {
+        current->used.store(0, Thread::Order::relaxed);
+    }
+    return_chunks(full);
+    free_chunks(large);
+    full = null;
+    large = null;
+    allocated.store(0, Thread::Order::relaxed);
+}
+
+} // namespace rpp
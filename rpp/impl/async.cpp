@@ -0,0 +1,68 @@
+
+#include "../async.h"
+
+namespace rpp::Async {
+
+Event::~Event() noexcept {
+    uptr head = state.load(Thread::Order::relaxed);
+    assert(head == 0 || head == SIGNALED);
+    if(is_sys()) close_sys();
+}
+
+void Event::signal() noexcept {
+    if(is_sys()) {
+        signal_sys();
+        return;
+    }
+
+    uptr head = state.exchange(SIGNALED, Thread::Order::acq_rel);
+    if(head == SIGNALED) return;
+
+    // Resume in arrival order.
+    detail::Event_Waiter* waiters = null;
+    detail::Event_Waiter* waiter = reinterpret_cast<detail::Event_Waiter*>(head);
+    while(waiter) {
+        detail::Event_Waiter* next = waiter->next;
+        waiter->next = waiters;
+        waiters = waiter;
+        waiter = next;
+    }
+
+    // Copies each node out before enqueueing it, as the resumed coroutine may immediately
+    // destroy it. Consecutive waiters on the same pool and priority are enqueued as one batch.
+    constexpr u64 batch = 64;
+    Array<Handle<>, batch> handles;
+    u64 n = 0;
+    void* pool = null;
+    void (*enqueue)(void*, Slice<Handle<>>, Thread::Priority) = null;
+    Thread::Priority priority = Thread::Priority::normal;
+    for(waiter = waiters; waiter;) {
+        detail::Event_Waiter* next = waiter->next;
+        if(n == batch || (n > 0 && (waiter->pool != pool || waiter->priority != priority))) {
+            enqueue(pool, Slice<Handle<>>{handles.data(), n}, priority);
+            n = 0;
+        }
+        pool = waiter->pool;
+        enqueue = waiter->enqueue;
+        priority = waiter->priority;
+        handles[n++] = Handle<>{waiter->handle};
+        waiter = next;
+    }
+    if(n > 0) enqueue(pool, Slice<Handle<>>{handles.data(), n}, priority);
+}
+
+void Event::reset() noexcept {
+    if(is_sys()) {
+        reset_sys();
+        return;
+    }
+    // Has no effect unless signalled, so waiters are never lost.
+    static_cast<void>(state.compare_and_swap(SIGNALED, 0, Thread::Order::relaxed));
+}
+
+[[nodiscard]] bool Event::try_wait() const noexcept {
+    if(is_sys()) return try_wait_sys();
+    return state.load(Thread::Order::acquire) == SIGNALED;
+}
+
+} // namespace rpp::Async
@@ -32,6 +32,10 @@ void* memcpy(void* dest, const void* src, u64 bytes) noexcept {
     return ::memcpy(dest, src, bytes);
 }
 
+void* memmove(void* dest, const void* src, u64 bytes) noexcept {
+    return ::memmove(dest, src, bytes);
+}
+
 [[nodiscard]] i32 snprintf(u8* buffer, u64 buffer_size, const char* fmt, ...) noexcept {
     va_list args;
     va_start(args, fmt);
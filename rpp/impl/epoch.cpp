@@ -0,0 +1,196 @@
+
+#include "../epoch.h"
+
+namespace rpp::Epoch {
+
+// Retiring this many objects triggers a collection.
+constexpr u64 COLLECT_INTERVAL = 64;
+
+struct Retired {
+    void* ptr = null;
+    void (*destroy)(void*) = null;
+    u64 epoch = 0;
+};
+
+// One per registered thread. Records are recycled, never unlinked, so the list can be scanned
+// without locking.
+struct Record {
+    // (epoch << 1) | 1 while pinned, zero otherwise.
+    Thread::Atomic<u64> state;
+    Thread::Atomic<bool> in_use;
+    Record* next = null;
+};
+
+struct Local {
+    Local() noexcept = default;
+    ~Local() noexcept;
+
+    Record* record = null;
+    u64 depth = 0;
+    u64 since_collect = 0;
+    Queue<Retired, Alloc> retired;
+};
+
+static Thread::Atomic<u64> g_epoch;
+static Thread::Atomic<Record*> g_records;
+
+static Thread::Mutex g_orphans_lock;
+static Queue<Retired, Alloc> g_orphans;
+static bool g_finalizer_registered = false;
+
+static thread_local Local g_local;
+
+// Objects retired in epoch e may still be referenced by threads pinned in e. Advancing to e + 1
+// requires every pinned thread to be in e, and advancing to e + 2 requires them all to be in
+// e + 1, so by then no such reference remains.
+static void destroy_expired(Queue<Retired, Alloc>& retired, u64 epoch) noexcept {
+    while(!retired.empty() && retired.front().epoch + 2 <= epoch) {
+        Retired r = retired.front();
+        retired.pop();
+        r.destroy(r.ptr);
+    }
+}
+
+static void destroy_all(Queue<Retired, Alloc>& retired) noexcept {
+    while(!retired.empty()) {
+        Retired r = retired.front();
+        retired.pop();
+        r.destroy(r.ptr);
+    }
+    retired = Queue<Retired, Alloc>{};
+}
+
+static void finalize() noexcept {
+    // All other threads have exited, so nothing retired is reachable.
+    destroy_all(g_local.retired);
+    {
+        Thread::Lock lock(g_orphans_lock);
+        destroy_all(g_orphans);
+    }
+    Record* record = g_records.exchange(null);
+    while(record) {
+        Record* next = record->next;
+        Pool_Adaptor<Alloc>::destroy(record);
+        record = next;
+    }
+    g_local.record = null;
+}
+
+[[nodiscard]] static Record* acquire_record() noexcept {
+    for(Record* r = g_records.load(Thread::Order::acquire); r; r = r->next) {
+        if(!r->in_use.load(Thread::Order::relaxed) &&
+           !r->in_use.compare_and_swap(false, true, Thread::Order::acquire)) {
+            return r;
+        }
+    }
+
+    {
+        Thread::Lock lock(g_orphans_lock);
+        if(!g_finalizer_registered) {
+            g_finalizer_registered = true;
+            Profile::finalizer([]() { finalize(); });
+        }
+    }
+
+    Record* record = Pool_Adaptor<Alloc>::make<Record>();
+    record->in_use.store(true, Thread::Order::relaxed);
+
+    Record* head = g_records.load(Thread::Order::relaxed);
+    for(;;) {
+        record->next = head;
+        Record* prev = g_records.compare_and_swap(head, record, Thread::Order::release);
+        if(prev == head) return record;
+        head = prev;
+    }
+}
+
+[[nodiscard]] static bool try_advance() noexcept {
+    u64 epoch = g_epoch.load();
+    for(Record* r = g_records.load(Thread::Order::acquire); r; r = r->next) {
+        u64 state = r->state.load(Thread::Order::acquire);
+        if((state & 1) && (state >> 1) != epoch) return false;
+    }
+    return g_epoch.compare_and_swap(epoch, epoch + 1, Thread::Order::acq_rel) == epoch;
+}
+
+Local::~Local() noexcept {
+    if(!record) return;
+    assert(depth == 0);
+
+    collect();
+    if(!retired.empty()) {
+        Thread::Lock lock(g_orphans_lock);
+        while(!retired.empty()) {
+            g_orphans.push(retired.front());
+            retired.pop();
+        }
+    }
+
+    record->state.store(0, Thread::Order::release);
+    record->in_use.store(false, Thread::Order::release);
+    record = null;
+}
+
+void enter() noexcept {
+    Local& local = g_local;
+    if(local.depth++ > 0) return;
+    if(!local.record) local.record = acquire_record();
+
+    u64 epoch = g_epoch.load(Thread::Order::relaxed);
+    local.record->state.store((epoch << 1) | 1, Thread::Order::relaxed);
+    // The pin must be visible to try_advance before we load any shared pointer.
+    Thread::fence();
+}
+
+void exit() noexcept {
+    Local& local = g_local;
+    assert(local.depth > 0);
+    if(--local.depth > 0) return;
+    local.record->state.store(0, Thread::Order::release);
+}
+
+void retire(void* ptr, void (*destroy)(void*)) noexcept {
+    Local& local = g_local;
+    if(!local.record) local.record = acquire_record();
+
+    // The object was unlinked before this point, so any reader that can still see it pinned
+    // an epoch no later than the one we read here.
+    Thread::fence();
+    local.retired.push(Retired{ptr, destroy, g_epoch.load(Thread::Order::relaxed)});
+
+    if(++local.since_collect >= COLLECT_INTERVAL) collect();
+}
+
+void collect() noexcept {
+    Local& local = g_local;
+    local.since_collect = 0;
+
+    static_cast<void>(try_advance());
+    u64 epoch = g_epoch.load(Thread::Order::acquire);
+
+    destroy_expired(local.retired, epoch);
+    if(g_orphans_lock.try_lock()) {
+        destroy_expired(g_orphans, epoch);
+        g_orphans_lock.unlock();
+    }
+}
+
+[[nodiscard]] u64 pending() noexcept {
+    return g_local.retired.length();
+}
+
+[[nodiscard]] static bool orphans_pending() noexcept {
+    Thread::Lock lock(g_orphans_lock);
+    return !g_orphans.empty();
+}
+
+void synchronize() noexcept {
+    assert(g_local.depth == 0);
+    for(;;) {
+        collect();
+        if(pending() == 0 && !orphans_pending()) return;
+        Thread::pause();
+    }
+}
+
+} // namespace rpp::Epoch
@@ -0,0 +1,183 @@
+
+#include "../base.h"
+
+namespace rpp::Intern {
+
+// Must not log allocations: Profile interns allocator names from inside Mallocator.
+using Alloc = Mhidden;
+
+constexpr u64 CHUNK_SIZE = Math::KB(64);
+constexpr u64 PAGE_BITS = 12;
+constexpr u64 PAGE_SIZE = u64{1} << PAGE_BITS;
+constexpr u64 MAX_PAGES = 1024;
+constexpr u64 INITIAL_CAPACITY = 256;
+
+struct Record {
+    u64 length = 0;
+
+    [[nodiscard]] u8* data() noexcept {
+        return reinterpret_cast<u8*>(this + 1);
+    }
+};
+
+// Bump storage for records. Only written while holding the table lock.
+struct Chunk {
+    Chunk* next = null;
+    u64 used = 0;
+    u64 size = 0;
+
+    [[nodiscard]] u8* data() noexcept {
+        return reinterpret_cast<u8*>(this + 1);
+    }
+};
+
+// Open addressing with linear probing. Each slot holds the high half of the string's hash
+// above its symbol id, or zero when empty. Slots only ever go from empty to full, and a table
+// is never freed while symbols are live, so readers may probe without locking.
+struct Table {
+    u64 capacity = 0;
+    Table* prev = null;
+
+    [[nodiscard]] Thread::Atomic<u64>* slots() noexcept {
+        return reinterpret_cast<Thread::Atomic<u64>*>(this + 1);
+    }
+};
+
+static Thread::Mutex g_lock;
+static Thread::Atomic<Table*> g_table;
+static Record** g_pages[MAX_PAGES] = {};
+static Chunk* g_chunks = null;
+static u64 g_count = 0;
+static Thread::Atomic<bool> g_finalized;
+
+[[nodiscard]] static Record* record(u32 id) noexcept {
+    return g_pages[id >> PAGE_BITS][id & (PAGE_SIZE - 1)];
+}
+
+[[nodiscard]] static Opt<Symbol> lookup(Table* table, String_View string, u64 hash) noexcept {
+    if(!table) return {};
+    u64 mask = table->capacity - 1;
+    for(u64 i = hash & mask;; i = (i + 1) & mask) {
+        u64 slot = table->slots()[i].load(Thread::Order::acquire);
+        if(slot == 0) return {};
+        if((slot >> 32) != (hash >> 32)) continue;
+        u32 id = static_cast<u32>(slot);
+        Record* r = record(id);
+        if(r->length == string.length() &&
+           Libc::memcmp(r->data(), string.data(), string.length()) == 0) {
+            return Opt<Symbol>{Symbol{id}};
+        }
+    }
+}
+
+static void insert(Table* table, u64 hash, u64 id) noexcept {
+    u64 mask = table->capacity - 1;
+    for(u64 i = hash & mask;; i = (i + 1) & mask) {
+        if(table->slots()[i].load(Thread::Order::relaxed) == 0) {
+            table->slots()[i].store((hash & ~u64{0xffffffff}) | id, Thread::Order::release);
+            return;
+        }
+    }
+}
+
+[[nodiscard]] static Table* make_table(u64 capacity) noexcept {
+    Table* table = reinterpret_cast<Table*>(
+        Alloc::alloc(sizeof(Table) + capacity * sizeof(Thread::Atomic<u64>)));
+    new(table) Table{capacity, null};
+    for(u64 i = 0; i < capacity; i++) new(&table->slots()[i]) Thread::Atomic<u64>{};
+    return table;
+}
+
+// Slots don't store the low half of the hash, so growing rehashes each record. The old table
+// stays allocated for readers that may still be probing it.
+[[nodiscard]] static Table* grow(Table* old) noexcept {
+    Table* table = make_table(old ? old->capacity * 2 : INITIAL_CAPACITY);
+    table->prev = old;
+    for(u64 id = 1; id <= g_count; id++) {
+        Record* r = record(static_cast<u32>(id));
+        u64 hash = rpp::hash(String_View{r->data(), r->length});
+        insert(table, hash, id);
+    }
+    g_table.store(table, Thread::Order::release);
+    return table;
+}
+
+[[nodiscard]] static Record* store(String_View string) noexcept {
+    u64 size = Math::align(sizeof(Record) + string.length(), alignof(Record));
+    if(!g_chunks || g_chunks->used + size > g_chunks->size) {
+        u64 capacity = Math::max(CHUNK_SIZE - sizeof(Chunk), size);
+        Chunk* chunk = new(Alloc::alloc(sizeof(Chunk) + capacity)) Chunk{g_chunks, 0, capacity};
+        g_chunks = chunk;
+    }
+    Record* r = new(g_chunks->data() + g_chunks->used) Record{string.length()};
+    Libc::memcpy(r->data(), string.data(), string.length());
+    g_chunks->used += size;
+    return r;
+}
+
+[[nodiscard]] Symbol get(String_View string) noexcept {
+    u64 hash = rpp::hash(string);
+    if(Opt<Symbol> symbol = lookup(g_table.load(Thread::Order::acquire), string, hash)) {
+        return *symbol;
+    }
+
+    Thread::Lock lock(g_lock);
+    // Don't build a new table that would never be freed.
+    if(g_finalized.load(Thread::Order::relaxed)) return Symbol{};
+    Table* table = g_table.load(Thread::Order::relaxed);
+    if(Opt<Symbol> symbol = lookup(table, string, hash)) return *symbol;
+
+    u64 id = g_count + 1;
+    if(id >= MAX_PAGES * PAGE_SIZE) die("Intern: too many symbols.");
+    Record**& page = g_pages[id >> PAGE_BITS];
+    if(!page) page = reinterpret_cast<Record**>(Alloc::alloc(sizeof(Record*) * PAGE_SIZE));
+    page[id & (PAGE_SIZE - 1)] = store(string);
+    g_count = id;
+
+    // Stay at most half full so probes are short.
+    if(!table || 2 * id > table->capacity) {
+        table = grow(table);
+    } else {
+        insert(table, hash, id);
+    }
+    return Symbol{static_cast<u32>(id)};
+}
+
+[[nodiscard]] Opt<Symbol> find(String_View string) noexcept {
+    return lookup(g_table.load(Thread::Order::acquire), string, rpp::hash(string));
+}
+
+[[nodiscard]] String_View Symbol::view() const noexcept {
+    assert(id != 0);
+    assert(!g_finalized.load(Thread::Order::relaxed));
+    Record* r = record(id);
+    return String_View{r->data(), r->length};
+}
+
+[[nodiscard]] u64 size() noexcept {
+    Thread::Lock lock(g_lock);
+    return g_count;
+}
+
+void finalize() noexcept {
+    Thread::Lock lock(g_lock);
+    Table* table = g_table.exchange(null, Thread::Order::relaxed);
+    while(table) {
+        Table* prev = table->prev;
+        Alloc::free(table);
+        table = prev;
+    }
+    while(g_chunks) {
+        Chunk* next = g_chunks->next;
+        Alloc::free(g_chunks);
+        g_chunks = next;
+    }
+    for(Record**& page : g_pages) {
+        Alloc::free(page);
+        page = null;
+    }
+    g_count = 0;
+    g_finalized.store(true, Thread::Order::relaxed);
+}
+
+} // namespace rpp::Intern
@@ -16,7 +16,7 @@ namespace rpp {
 }
 
 void Profile::register_thread() noexcept {
-    Thread::Lock lock(threads_lock);
+    Thread::Write_Lock lock(threads_lock);
 
     Thread::Id id = Thread::this_id();
     assert(!threads.contains(id));
@@ -27,7 +27,7 @@ void Profile::register_thread() noexcept {
 }
 
 void Profile::unregister_thread() noexcept {
-    Thread::Lock lock(threads_lock);
+    Thread::Write_Lock lock(threads_lock);
 
     Thread::Id id = Thread::this_id();
     static_cast<void>(threads.try_erase(id));
@@ -37,7 +37,8 @@ void Profile::unregister_thread() noexcept {
 
 [[nodiscard]] Profile::Time_Point Profile::Frame_Profile::begin() noexcept {
     assert(current_node == 0 && nodes.empty());
-    Timing_Node& node = nodes.push(Timing_Node::make(Log::Location{"Frame"_v, {}, 0}, 0));
+    Timing_Node& node =
+        nodes.push(Timing_Node::make(Log::Location{"Frame"_v, {}, 0}, Intern::get<"Frame">(), 0));
     return node.begin;
 }
 
@@ -103,7 +104,15 @@ void Profile::end_frame() noexcept {
 void Profile::enter(String_View name) noexcept {
     if constexpr(DO_PROFILE) {
         if(!this_thread.ready()) return;
-        enter(Log::Location{move(name), ""_v, 0});
+        enter(Intern::get(name));
+    }
+}
+
+void Profile::enter(Intern::Symbol name) noexcept {
+    if constexpr(DO_PROFILE) {
+        if(!this_thread.ready()) return;
+        Thread::Lock lock(this_thread.frames_lock);
+        this_thread.frames.back().enter(name);
     }
 }
 
@@ -115,28 +124,49 @@ void Profile::enter(Log::Location loc) noexcept {
     }
 }
 
-void Profile::Frame_Profile::enter(Log::Location loc) noexcept {
+// Locations from the same call site share their string literals, so repeats rarely compare bytes.
+[[nodiscard]] static bool same_view(String_View a, String_View b) noexcept {
+    return (a.data() == b.data() && a.length() == b.length()) || a == b;
+}
 
-    bool repeat = false;
-    Timing_Node& node = nodes[current_node];
+void Profile::Frame_Profile::enter(Log::Location loc) noexcept {
+    for(u64 child_idx : nodes[current_node].children) {
+        Log::Location& site = nodes[child_idx].loc;
+        if(site.line == loc.line && same_view(site.function, loc.function) &&
+           same_view(site.file, loc.file)) {
+            repeat(child_idx);
+            return;
+        }
+    }
+    // Only the first entry from a call site under this parent interns its function name.
+    Intern::Symbol name = Intern::get(loc.function);
+    push(move(loc), name);
+}
 
-    for(u64 child_idx : node.children) {
+void Profile::Frame_Profile::enter(Intern::Symbol name) noexcept {
+    for(u64 child_idx : nodes[current_node].children) {
         Timing_Node& child = nodes[child_idx];
-        if(child.loc == loc) {
-            current_node = child_idx;
-            repeat = true;
+        // Named scopes have no line, which keeps them apart from call sites.
+        if(child.name == name && child.loc.line == 0) {
+            repeat(child_idx);
+            return;
         }
     }
+    push(Log::Location{name.view(), ""_v, 0}, name);
+}
 
-    if(!repeat) {
-        u64 child_idx = nodes.length();
-        node.children.push(child_idx);
-        nodes.push(Timing_Node::make(move(loc), current_node));
-        current_node = child_idx;
-    } else {
-        node.begin = timestamp();
-        node.calls++;
-    }
+void Profile::Frame_Profile::repeat(u64 child_idx) noexcept {
+    Timing_Node& node = nodes[current_node];
+    current_node = child_idx;
+    node.begin = timestamp();
+    node.calls++;
+}
+
+void Profile::Frame_Profile::push(Log::Location loc, Intern::Symbol name) noexcept {
+    u64 child_idx = nodes.length();
+    nodes[current_node].children.push(child_idx);
+    nodes.push(Timing_Node::make(move(loc), name, current_node));
+    current_node = child_idx;
 }
 
 void Profile::exit() noexcept {
@@ -161,6 +191,7 @@ void Profile::alloc(Alloc a) noexcept {
     if constexpr(DO_PROFILE) {
         {
             Thread::Lock lock(allocs_lock);
+            if(allocs_finalized) return;
             Alloc_Profile& prof = allocs.get_or_insert(a.name);
 
             if(a.size) {
@@ -228,9 +259,11 @@ void Profile::finalize() noexcept {
             }
         }
         allocs.~Map();
+        allocs_finalized = true;
     }
+    Intern::finalize();
     {
-        Thread::Lock lock(threads_lock);
+        Thread::Write_Lock lock(threads_lock);
         threads.~Map();
     }
     i64 net = sys_net_allocs();
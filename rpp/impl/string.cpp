@@ -0,0 +1,140 @@
+
+#include "../base.h"
+
+#include <immintrin.h>
+
+#ifndef __AVX2__
+#error "Unsupported architecture: AVX2 is required".
+#endif
+
+namespace rpp {
+
+namespace detail {
+
+constexpr u64 STRING_BLOCK = 32;
+
+[[nodiscard]] static __m256i load(const u8* data) noexcept {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+[[nodiscard]] static u32 match(__m256i a, __m256i b) noexcept {
+    return static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+}
+
+// Adds delta to every byte of data in [lo, hi].
+static void shift_range(u8* data, u64 length, u8 lo, u8 hi, i8 delta) noexcept {
+    __m256i below = _mm256_set1_epi8(static_cast<char>(lo - 1));
+    __m256i above = _mm256_set1_epi8(static_cast<char>(hi + 1));
+    __m256i add = _mm256_set1_epi8(delta);
+    u64 i = 0;
+    for(; i + STRING_BLOCK <= length; i += STRING_BLOCK) {
+        __m256i v = load(data + i);
+        __m256i in = _mm256_and_si256(_mm256_cmpgt_epi8(v, below), _mm256_cmpgt_epi8(above, v));
+        v = _mm256_add_epi8(v, _mm256_and_si256(in, add));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), v);
+    }
+    for(; i < length; i++) {
+        if(data[i] >= lo && data[i] <= hi) data[i] += delta;
+    }
+}
+
+} // namespace detail
+
+[[nodiscard]] Opt<u64> String_View::find(u8 c) const noexcept {
+    __m256i needle = _mm256_set1_epi8(static_cast<char>(c));
+    u64 i = 0;
+    for(; i + detail::STRING_BLOCK <= length_; i += detail::STRING_BLOCK) {
+        u32 mask = detail::match(detail::load(data_ + i), needle);
+        if(mask) return Opt<u64>{i + Math::cttz(mask)};
+    }
+    for(; i < length_; i++) {
+        if(data_[i] == c) return Opt<u64>{i};
+    }
+    return {};
+}
+
+[[nodiscard]] Opt<u64> String_View::find(String_View needle) const noexcept {
+    u64 n = needle.length();
+    if(n == 0) return Opt<u64>{0};
+    if(n > length_) return {};
+    if(n == 1) return find(needle[0]);
+
+    // Only positions where both the first and last bytes match are compared in full.
+    __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    __m256i last = _mm256_set1_epi8(static_cast<char>(needle[n - 1]));
+    u64 end = length_ - n + 1;
+    u64 i = 0;
+    for(; i + detail::STRING_BLOCK <= end; i += detail::STRING_BLOCK) {
+        u32 mask = detail::match(detail::load(data_ + i), first) &
+                   detail::match(detail::load(data_ + i + n - 1), last);
+        while(mask) {
+            u64 at = i + Math::cttz(mask);
+            if(Libc::memcmp(data_ + at + 1, needle.data() + 1, n - 2) == 0) {
+                return Opt<u64>{at};
+            }
+            mask &= mask - 1;
+        }
+    }
+    for(; i < end; i++) {
+        if(Libc::memcmp(data_ + i, needle.data(), n) == 0) return Opt<u64>{i};
+    }
+    return {};
+}
+
+[[nodiscard]] Opt<u64> String_View::find_any(String_View set) const noexcept {
+    constexpr u64 max_vector_set = 8;
+
+    if(set.length() <= max_vector_set) {
+        __m256i chars[max_vector_set];
+        for(u64 j = 0; j < set.length(); j++) {
+            chars[j] = _mm256_set1_epi8(static_cast<char>(set[j]));
+        }
+        u64 i = 0;
+        for(; i + detail::STRING_BLOCK <= length_; i += detail::STRING_BLOCK) {
+            __m256i v = detail::load(data_ + i);
+            u32 mask = 0;
+            for(u64 j = 0; j < set.length(); j++) mask |= detail::match(v, chars[j]);
+            if(mask) return Opt<u64>{i + Math::cttz(mask)};
+        }
+        for(; i < length_; i++) {
+            for(u8 c : set) {
+                if(data_[i] == c) return Opt<u64>{i};
+            }
+        }
+        return {};
+    }
+
+    bool table[256] = {};
+    for(u8 c : set) table[c] = true;
+    for(u64 i = 0; i < length_; i++) {
+        if(table[data_[i]]) return Opt<u64>{i};
+    }
+    return {};
+}
+
+[[nodiscard]] u64 String_View::count(u8 c) const noexcept {
+    __m256i needle = _mm256_set1_epi8(static_cast<char>(c));
+    u64 n = 0;
+    u64 i = 0;
+    for(; i + detail::STRING_BLOCK <= length_; i += detail::STRING_BLOCK) {
+        n += Math::popcount(detail::match(detail::load(data_ + i), needle));
+    }
+    for(; i < length_; i++) {
+        if(data_[i] == c) n++;
+    }
+    return n;
+}
+
+namespace ascii {
+
+void to_uppercase(u8* data, u64 length) noexcept {
+    detail::shift_range(data, length, 'a', 'z', 'A' - 'a');
+}
+
+void to_lowercase(u8* data, u64 length) noexcept {
+    detail::shift_range(data, length, 'A', 'Z', 'a' - 'A');
+}
+
+} // namespace ascii
+
+} // namespace rpp
@@ -0,0 +1,143 @@
+
+#include "../base.h"
+
+namespace rpp::Thread {
+
+#ifndef RPP_RELEASE_BUILD
+static Atomic<u64> g_mutex_contentions;
+#endif
+
+// Spinning only pays off for critical sections shorter than a futex round trip.
+constexpr u64 MUTEX_SPINS = 100;
+
+[[nodiscard]] u64 Mutex::contentions() noexcept {
+#ifndef RPP_RELEASE_BUILD
+    return g_mutex_contentions.load(Order::relaxed);
+#else
+    return 0;
+#endif
+}
+
+void Mutex::lock_slow() noexcept {
+#ifndef RPP_RELEASE_BUILD
+    g_mutex_contentions.incr(Order::relaxed);
+#endif
+    for(u64 i = 0; i < MUTEX_SPINS; i++) {
+        u32 s = state.load(Order::relaxed);
+        if(s == UNLOCKED) {
+            if(state.compare_and_swap(UNLOCKED, LOCKED, Order::acquire) == UNLOCKED) return;
+        } else if(s == CONTENDED) {
+            // Others are already parked; spinning would only delay joining them.
+            break;
+        }
+        pause();
+    }
+    lock_contended();
+}
+
+void Mutex::lock_contended() noexcept {
+    // We can't know whether we're the last waiter, so always leave the mutex marked as
+    // contended. At worst unlock makes one unnecessary wake call.
+    while(state.exchange(CONTENDED, Order::acquire) != UNLOCKED) {
+        state.wait(CONTENDED, Order::relaxed);
+    }
+}
+
+void Cond::wait(Mutex& mut) noexcept {
+    u32 current = sequence.load();
+    waiters.incr();
+    mut.unlock();
+    // Returns once any signal or broadcast has happened since we sampled the sequence.
+    sequence.wait(current);
+    waiters.decr(Order::relaxed);
+    mut.lock_contended();
+}
+
+RwLock::~RwLock() noexcept {
+    assert(state.load(Order::relaxed) == 0);
+}
+
+[[nodiscard]] bool RwLock::try_lock_shared() noexcept {
+    u32 s = state.load(Order::relaxed);
+    while(!(s & (WRITER | WRITERS_WAITING)) && (s & READERS) < READERS) {
+        u32 prev = state.compare_and_swap(s, s + 1, Order::acquire);
+        if(prev == s) return true;
+        s = prev;
+    }
+    return false;
+}
+
+[[nodiscard]] bool RwLock::try_lock() noexcept {
+    u32 s = state.load(Order::relaxed);
+    while(!(s & (READERS | WRITER))) {
+        u32 prev = state.compare_and_swap(s, s | WRITER, Order::acquire);
+        if(prev == s) return true;
+        s = prev;
+    }
+    return false;
+}
+
+void RwLock::lock_shared_slow() noexcept {
+    u32 s = state.load(Order::relaxed);
+    for(;;) {
+        // Queue behind waiting writers so they can't starve.
+        if(!(s & (WRITER | WRITERS_WAITING))) {
+            assert((s & READERS) < READERS);
+            u32 prev = state.compare_and_swap(s, s + 1, Order::acquire);
+            if(prev == s) return;
+            s = prev;
+            continue;
+        }
+        if(!(s & READERS_WAITING)) {
+            u32 prev = state.compare_and_swap(s, s | READERS_WAITING, Order::relaxed);
+            if(prev != s) {
+                s = prev;
+                continue;
+            }
+            s |= READERS_WAITING;
+        }
+        state.wait(s, Order::relaxed);
+        s = state.load(Order::relaxed);
+    }
+}
+
+void RwLock::lock_slow() noexcept {
+    u32 s = state.load(Order::relaxed);
+    bool waited = false;
+    for(;;) {
+        if(!(s & (READERS | WRITER))) {
+            // unlock cleared the waiting bit before waking us, but other writers may still be
+            // asleep and we can't tell, so set it again once we have slept: our unlock will then
+            // wake the next writer. The last one out clears it with a spurious wakeup.
+            u32 next = s | WRITER;
+            if(waited) next |= WRITERS_WAITING;
+            else next &= ~WRITERS_WAITING;
+            u32 prev = state.compare_and_swap(s, next, Order::acquire);
+            if(prev == s) return;
+            s = prev;
+            continue;
+        }
+        if(!(s & WRITERS_WAITING)) {
+            u32 prev = state.compare_and_swap(s, s | WRITERS_WAITING, Order::relaxed);
+            if(prev != s) {
+                s = prev;
+                continue;
+            }
+        }
+        // Sample the wakeup counter, then check that the lock is still held: an unlock that
+        // happens after the check bumps the counter and wait returns immediately.
+        u32 wakeups = writer_wakeups.load(Order::acquire);
+        s = state.load(Order::relaxed);
+        if(!(s & WRITERS_WAITING) || !(s & (READERS | WRITER))) continue;
+        writer_wakeups.wait(wakeups, Order::relaxed);
+        waited = true;
+        s = state.load(Order::relaxed);
+    }
+}
+
+void RwLock::wake_writer() noexcept {
+    writer_wakeups.fetch_add(1, Order::release);
+    writer_wakeups.notify_one();
+}
+
+} // namespace rpp::Thread
@@ -1,8 +1,14 @@
 
 #include "alloc.cpp"
+#include "arena.cpp"
+#include "async.cpp"
 #include "base.cpp"
+#include "epoch.cpp"
+#include "intern.cpp"
 #include "log.cpp"
 #include "math.cpp"
 #include "profile.cpp"
 #include "simd.cpp"
+#include "string.cpp"
+#include "thread.cpp"
 #include "vmath.cpp"
@@ -0,0 +1,90 @@
+
+#pragma once
+
+#ifndef RPP_BASE
+#error "Include base.h instead."
+#endif
+
+// Process-wide string interning. Each distinct string maps to a stable u32 symbol, so symbols
+// hash and compare in constant time. Looking up a string that is already interned takes no
+// lock; interning a new one does. Interned bytes live until Profile::finalize.
+
+namespace rpp::Intern {
+
+struct Symbol {
+    u32 id = 0;
+
+    [[nodiscard]] bool operator==(const Symbol& other) const noexcept {
+        return id == other.id;
+    }
+    [[nodiscard]] explicit operator bool() const noexcept {
+        return id != 0;
+    }
+
+    [[nodiscard]] String_View view() const noexcept;
+};
+
+// Returns the symbol for string, interning it if necessary.
+[[nodiscard]] Symbol get(String_View string) noexcept;
+
+// Interns a literal once per call site.
+template<Literal L>
+[[nodiscard]] Symbol get() noexcept {
+    static const Symbol symbol = get(String_View{L});
+    return symbol;
+}
+
+// Returns the symbol for string only if it has already been interned.
+[[nodiscard]] Opt<Symbol> find(String_View string) noexcept;
+
+// Number of interned strings.
+[[nodiscard]] u64 size() noexcept;
+
+// Frees all interned strings. Existing symbols are invalid afterwards, and get returns the
+// invalid symbol.
+void finalize() noexcept;
+
+} // namespace rpp::Intern
+
+namespace rpp {
+
+RPP_NAMED_RECORD(Intern::Symbol, "Symbol", RPP_FIELD(id));
+
+namespace Hash {
+
+template<>
+struct Hash<Intern::Symbol> {
+    [[nodiscard]] constexpr static u64 hash(Intern::Symbol symbol) noexcept {
+        return squirrel5(symbol.id);
+    }
+};
+
+} // namespace Hash
+
+namespace Format {
+
+template<>
+struct Measure<Intern::Symbol> {
+    [[nodiscard]] static u64 measure(Intern::Symbol symbol) noexcept {
+        return symbol.view().length();
+    }
+};
+
+template<Allocator O>
+struct Write<O, Intern::Symbol> {
+    [[nodiscard]] static u64 write(String<O>& output, u64 idx, Intern::Symbol symbol) noexcept {
+        return output.write(idx, symbol.view());
+    }
+};
+
+template<>
+struct Append<Intern::Symbol> {
+    template<Allocator O>
+    static void append(String_Builder<O>& output, Intern::Symbol symbol) noexcept {
+        output.append(symbol.view());
+    }
+};
+
+} // namespace Format
+
+} // namespace rpp
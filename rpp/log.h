@@ -14,13 +14,13 @@
 #define RPP_HERE ::rpp::Log::Location::make(__FILE__, __LINE__, RPP_PRETTY_FUNCTION)
 
 #define info(fmt, ...)                                                                             \
-    (void)(::rpp::Log::log(::rpp::Log::Level::info, RPP_HERE, fmt##_v, ##__VA_ARGS__), 0)
+    (void)(::rpp::Log::log(::rpp::Log::Level::info, RPP_HERE, fmt##_f, ##__VA_ARGS__), 0)
 
 #define warn(fmt, ...)                                                                             \
-    (void)(::rpp::Log::log(::rpp::Log::Level::warn, RPP_HERE, fmt##_v, ##__VA_ARGS__), 0)
+    (void)(::rpp::Log::log(::rpp::Log::Level::warn, RPP_HERE, fmt##_f, ##__VA_ARGS__), 0)
 
 #define die(fmt, ...)                                                                              \
-    (void)(::rpp::Log::log(::rpp::Log::Level::fatal, RPP_HERE, fmt##_v, ##__VA_ARGS__),            \
+    (void)(::rpp::Log::log(::rpp::Log::Level::fatal, RPP_HERE, fmt##_f, ##__VA_ARGS__),            \
            RPP_DEBUG_BREAK, ::rpp::Libc::exit(1), 0)
 
 #undef assert
@@ -45,6 +45,7 @@ namespace rpp {
 namespace Log {
 
 constexpr u64 INDENT_SIZE = 4;
+constexpr u64 LOG_BUFFER_SIZE = 512;
 
 enum class Level : u8 {
     info,
@@ -87,10 +88,12 @@ using Time = u64;
 void debug_break() noexcept;
 void output(Level level, const Location& loc, String_View msg) noexcept;
 
+// Defined in format.h. Messages longer than LOG_BUFFER_SIZE spill into a region.
 template<typename... Ts>
-void log(Level level, const Location& loc, String_View fmt, const Ts&... args) noexcept {
-    Region(R) output(level, move(loc), format<Mregion<R>>(fmt, args...).view());
-}
+void log(Level level, const Location& loc, String_View fmt, const Ts&... args) noexcept;
+template<Format::Static_String F, typename... Ts>
+void log(Level level, const Location& loc, Format::Static_Format<F> fmt,
+         const Ts&... args) noexcept;
 
 } // namespace Log
 
@@ -76,7 +76,7 @@ struct Map {
         shift_ = Math::ctlz(capacity_) + 1;
         usable_ = (capacity_ / 4) * 3;
         length_ = 0;
-        data_ = reinterpret_cast<Slot*>(A::alloc(capacity_ * sizeof(Slot)));
+        data_ = reinterpret_cast<Slot*>(Backing::alloc(capacity_ * sizeof(Slot)));
         Libc::memset(data_, 0, capacity_ * sizeof(Slot));
     }
 
@@ -122,7 +122,7 @@ struct Map {
                 data_[i].~Slot();
             }
         }
-        A::free(data_);
+        Backing::free(data_);
         data_ = null;
         capacity_ = 0;
         length_ = 0;
@@ -153,7 +153,7 @@ struct Map {
         u64 old_capacity = capacity_;
 
         capacity_ = new_capacity;
-        data_ = reinterpret_cast<Slot*>(A::alloc(capacity_ * sizeof(Slot)));
+        data_ = reinterpret_cast<Slot*>(Backing::alloc(capacity_ * sizeof(Slot)));
         Libc::memset(data_, 0, capacity_ * sizeof(Slot));
         usable_ = (capacity_ / 4) * 3;
         shift_ = Math::ctlz(capacity_) + 1;
@@ -161,7 +161,7 @@ struct Map {
         for(u64 i = 0; i < old_capacity; i++) {
             if(old_data[i].hash != Slot::EMPTY) static_cast<void>(insert_slot(move(old_data[i])));
         }
-        A::free(old_data);
+        Backing::free(old_data);
     }
 
     void grow() noexcept {
@@ -397,6 +397,8 @@ struct Map {
     }
 
 private:
+    using Backing = Aligned_Adaptor<A, alignof(Slot)>;
+
     [[nodiscard]] Slot& insert_slot(Slot&& slot) noexcept {
         u64 idx = slot.hash >> shift_;
         Slot* placement = null;
@@ -3,6 +3,7 @@
 
 #include "async.h"
 #include "base.h"
+#include "epoch.h"
 #include "thread.h"
 
 namespace rpp::Async {
@@ -10,13 +11,27 @@ namespace rpp::Async {
 template<Allocator A>
 struct Pool;
 
+namespace detail {
+template<Allocator A>
+struct Waiter;
+} // namespace detail
+
+using Priority = Thread::Priority;
+
+constexpr u64 PRIORITIES = static_cast<u64>(Priority::critical) + 1;
+
+// Number of jobs a worker may take from higher priority lanes while lower priority work is
+// waiting before it serves the lowest waiting lane once.
+constexpr u64 STARVATION_LIMIT = 16;
+
 template<Allocator A = Alloc>
 struct Schedule {
 
-    explicit Schedule(Pool<A>& pool) noexcept : pool{pool} {
+    explicit Schedule(Pool<A>& pool, Priority priority) noexcept
+        : pool{pool}, priority{priority} {
     }
     void await_suspend(std::coroutine_handle<> task) noexcept {
-        pool.enqueue(Handle{task});
+        pool.enqueue(Handle{task}, priority);
     }
     void await_resume() noexcept {
     }
@@ -26,15 +41,19 @@ struct Schedule {
 
 private:
     Pool<A>& pool;
+    Priority priority;
 };
 
 template<Allocator A = Alloc>
 struct Schedule_Event {
 
-    explicit Schedule_Event(Event event, Pool<A>& pool) noexcept : event{move(event)}, pool{pool} {
+    explicit Schedule_Event(Event event, Pool<A>& pool, Priority priority) noexcept
+        : event{move(event)}, pool{pool}, priority{priority} {
     }
     void await_suspend(std::coroutine_handle<> task) noexcept {
-        pool.enqueue_event(move(event), Handle{task});
+        // Nothing else can signal a user-space event once the pool owns it.
+        assert(event.is_sys());
+        pool.enqueue_event(move(event), Handle{task}, priority);
     }
     void await_resume() noexcept {
     }
@@ -45,30 +64,121 @@ struct Schedule_Event {
 private:
     Event event;
     Pool<A>& pool;
+    Priority priority;
+};
+
+template<Allocator A = Alloc>
+struct Wait_Event {
+
+    explicit Wait_Event(Event& event, Pool<A>& pool, Priority priority) noexcept
+        : event{event}, waiter{{}, &pool, &enqueue, priority, null} {
+    }
+    [[nodiscard]] bool await_ready() noexcept {
+        return event.try_wait();
+    }
+    [[nodiscard]] bool await_suspend(std::coroutine_handle<> task) noexcept {
+        waiter.handle = task;
+        uptr head = event.state.load(Thread::Order::acquire);
+        for(;;) {
+            if(head == Event::SIGNALED) return false;
+            waiter.next = reinterpret_cast<detail::Event_Waiter*>(head);
+            uptr prev = event.state.compare_and_swap(head, reinterpret_cast<uptr>(&waiter),
+                                                     Thread::Order::acq_rel);
+            if(prev == head) return true;
+            head = prev;
+        }
+    }
+    void await_resume() noexcept {
+    }
+
+private:
+    static void enqueue(void* pool, Slice<Handle<>> jobs, Priority priority) noexcept {
+        static_cast<Pool<A>*>(pool)->enqueue_batch(jobs, priority);
+    }
+
+    Event& event;
+    detail::Event_Waiter waiter;
+};
+
+// How a pool chooses the logical processors its workers are pinned to.
+enum class Placement : u8 {
+    // One worker per physical core across all nodes before using any SMT siblings.
+    physical_first,
+    // Only processors on the requested NUMA node, physical cores first.
+    numa_local,
 };
 
+// What a worker does when its queue runs dry.
+enum class Idle : u8 {
+    // Sleep on the queue's condition variable immediately.
+    park,
+    // Poll the queue for up to IDLE_SPINS pauses before sleeping. Trades CPU time for wakeup
+    // latency, and lets most enqueues skip signalling a sleeping worker.
+    spin_then_park,
+};
+
+constexpr u64 IDLE_SPINS = 4096;
+
 template<Allocator A = Alloc>
 struct Pool {
 
-    explicit Pool() noexcept
-        : thread_states{Vec<Thread_State, A>::make(Thread::hardware_threads() - 1)} {
+    explicit Pool(Placement placement = Placement::physical_first, u64 node = 0,
+                  Idle idle = Idle::spin_then_park) noexcept
+        : idle{idle} {
+        Vec<Thread::Cpu, Alloc> cpus = Thread::topology();
+        Vec<Thread::Cpu, Alloc> chosen;
 
-        u64 h_threads = Thread::hardware_threads();
-        u64 n_threads = thread_states.length();
-        assert(n_threads <= h_threads && n_threads <= 64);
+        if(placement == Placement::numa_local) {
+            Vec<Thread::Cpu, Alloc> local;
+            for(auto& cpu : cpus) {
+                if(cpu.node == node) local.push(cpu);
+            }
+            if(local.empty()) {
+                warn("No processors on NUMA node %, using all nodes.", node);
+            } else {
+                cpus = move(local);
+            }
+        }
 
-        for(u64 i = 0; i < n_threads; i++) {
-            threads.push(Thread::Thread([this, i, h_threads] {
-                u64 j = i < h_threads / 2 ? i * 2 : (i - h_threads / 2) * 2 + 1;
-                Thread::set_affinity(j);
-                do_work(i);
-            }));
+        // Take the first logical processor of each physical core, then the SMT siblings.
+        Vec<bool, Alloc> taken(cpus.length());
+        for(u64 i = 0; i < cpus.length(); i++) {
+            bool sibling = false;
+            for(u64 j = 0; j < i; j++) {
+                if(cpus[j].package == cpus[i].package && cpus[j].core == cpus[i].core) {
+                    sibling = true;
+                    break;
+                }
+            }
+            taken.push(!sibling);
+            if(!sibling) chosen.push(cpus[i]);
         }
-        pending_events.push(Event{});
-        event_thread = Thread::Thread([this] { do_events(); });
+        for(u64 i = 0; i < cpus.length(); i++) {
+            if(!taken[i]) chosen.push(cpus[i]);
+        }
+
+        // Leave a hardware thread for the event thread and the submitting thread.
+        if(chosen.length() == Thread::hardware_threads() && chosen.length() > 1) {
+            chosen.pop();
+        }
+        start(move(chosen));
     }
+
+    explicit Pool(Slice<u64> cpuset, Idle idle = Idle::spin_then_park) noexcept : idle{idle} {
+        Vec<Thread::Cpu, Alloc> cpus = Thread::topology();
+        Vec<Thread::Cpu, Alloc> chosen;
+        for(u64 id : cpuset) {
+            Thread::Cpu found{id, id, 0, 0};
+            for(auto& cpu : cpus) {
+                if(cpu.id == id) found = cpu;
+            }
+            chosen.push(found);
+        }
+        start(move(chosen));
+    }
+
     ~Pool() noexcept {
-        shutdown.exchange(true);
+        shutdown.store(true);
 
         for(auto& state : thread_states) {
             Thread::Lock lock(state.mut);
@@ -85,10 +195,12 @@ struct Pool {
         pending_events.clear();
 
         for(auto& state : thread_states) {
-            for(auto& job : state.jobs) {
-                // This still leaks pending continuations, as we can't control their destruction
-                // order wrt their waiting tasks.
-                job.handle.destroy();
+            for(auto& lane : state.jobs) {
+                for(auto& job : lane) {
+                    // This still leaks pending continuations, as we can't control their
+                    // destruction order wrt their waiting tasks.
+                    job.handle.destroy();
+                }
             }
         }
     }
@@ -99,64 +211,212 @@ struct Pool {
     Pool(Pool&&) noexcept = delete;
     Pool& operator=(Pool&&) noexcept = delete;
 
-    [[nodiscard]] Schedule<A> suspend() noexcept {
-        return Schedule<A>{*this};
+    [[nodiscard]] Schedule<A> suspend(Priority priority = Priority::normal) noexcept {
+        return Schedule<A>{*this, priority};
+    }
+    // Takes ownership of a kernel event and resumes once the event thread sees it signalled.
+    [[nodiscard]] Schedule_Event<A> event(Event event,
+                                          Priority priority = Priority::normal) noexcept {
+        return Schedule_Event<A>{move(event), *this, priority};
     }
-    [[nodiscard]] Schedule_Event<A> event(Event event) noexcept {
-        return Schedule_Event<A>{move(event), *this};
+    // Resumes on this pool once a user-space event is signalled.
+    [[nodiscard]] Wait_Event<A> wait(Event& event, Priority priority = Priority::normal) noexcept {
+        assert(!event.is_sys());
+        return Wait_Event<A>{event, *this, priority};
     }
 
     [[nodiscard]] u64 n_threads() const noexcept {
         return thread_states.length();
     }
 
+    // Schedules a batch of suspended coroutines, spread over as few workers as possible: idle
+    // workers get one contiguous share each, and each worker is locked and woken at most once.
+    // If every worker is busy, the jobs are queued without waking anyone.
+    void enqueue_batch(Slice<Handle<>> jobs, Priority priority = Priority::normal) noexcept {
+        if(jobs.length() == 0) return;
+        if(jobs.length() == 1) {
+            enqueue(jobs[0], priority);
+            return;
+        }
+
+        u64 n_threads = thread_states.length();
+        u64 begin = 0, end = n_threads;
+        if(this_pool == this) {
+            begin = thread_states[this_worker].peers_begin;
+            end = thread_states[this_worker].peers_end;
+        }
+
+        // Idle peers on the caller's node come first.
+        Array<u64, 64> targets;
+        u64 n_targets = 0;
+        for(u64 pass = 0; pass < 2; pass++) {
+            for(u64 i = 0; i < n_threads && n_targets < jobs.length(); i++) {
+                bool peer = i >= begin && i < end;
+                if(peer == (pass == 0) && thread_states[i].empty()) targets[n_targets++] = i;
+            }
+        }
+        if(n_targets == 0) {
+            u64 first = static_cast<u64>(sequence.incr(Thread::Order::relaxed) * Math::PHI32);
+            for(; n_targets < Math::min(jobs.length(), end - begin); n_targets++) {
+                targets[n_targets] = begin + (first + n_targets) % (end - begin);
+            }
+        }
+
+        u64 next = 0;
+        for(u64 t = 0; t < n_targets; t++) {
+            u64 share = (jobs.length() - next) / (n_targets - t);
+            Thread_State& state = thread_states[targets[t]];
+
+            Thread::Lock lock(state.mut);
+            for(u64 j = 0; j < share; j++) {
+                state.push(jobs[next++], priority);
+            }
+            state.wake();
+        }
+    }
+
 private:
-    void enqueue(Handle<> job) noexcept {
-        for(u64 i = 0; i < thread_states.length(); i++) {
-            Thread_State& state = thread_states[i];
-            // Race on empty
-            if(state.jobs.empty()) {
-                Thread::Lock lock(state.mut);
-                state.jobs.push(rpp::move(job));
-                state.cond.signal();
-                return;
+    void start(Vec<Thread::Cpu, Alloc> cpus) noexcept {
+        u64 n_threads = cpus.length();
+        assert(n_threads > 0 && n_threads <= 64);
+
+        // Group workers by NUMA node so each worker's peers form a contiguous range.
+        Vec<Thread::Cpu, Alloc> workers;
+        Vec<bool, Alloc> placed(n_threads);
+        for(u64 i = 0; i < n_threads; i++) {
+            placed.push(false);
+        }
+        for(u64 i = 0; i < n_threads; i++) {
+            if(placed[i]) continue;
+            for(u64 j = i; j < n_threads; j++) {
+                if(!placed[j] && cpus[j].node == cpus[i].node) {
+                    placed[j] = true;
+                    workers.push(cpus[j]);
+                }
+            }
+        }
+
+        thread_states = Vec<Thread_State, A>::make(n_threads);
+        for(u64 begin = 0; begin < n_threads;) {
+            u64 end = begin;
+            while(end < n_threads && workers[end].node == workers[begin].node) end++;
+            for(u64 i = begin; i < end; i++) {
+                thread_states[i].peers_begin = begin;
+                thread_states[i].peers_end = end;
             }
+            begin = end;
+        }
+
+        for(u64 i = 0; i < n_threads; i++) {
+            u64 cpu = workers[i].id;
+            threads.push(Thread::Thread([this, i, cpu] {
+                Thread::set_affinity(cpu);
+                this_pool = this;
+                this_worker = i;
+                do_work(i);
+            }));
+        }
+        pending_events.push(Event::make_sys());
+        event_thread = Thread::Thread([this] { do_events(); });
+    }
+
+    void enqueue(Handle<> job, Priority priority = Priority::normal) noexcept {
+        // Jobs submitted from a worker stay on its NUMA node when possible, near the memory
+        // the worker has been touching.
+        u64 begin = 0, end = thread_states.length();
+        if(this_pool == this) {
+            begin = thread_states[this_worker].peers_begin;
+            end = thread_states[this_worker].peers_end;
         }
 
+        auto try_idle = [&](u64 first, u64 last) {
+            for(u64 i = first; i < last; i++) {
+                Thread_State& state = thread_states[i];
+                // Race on empty
+                if(state.empty()) {
+                    Thread::Lock lock(state.mut);
+                    state.push(rpp::move(job), priority);
+                    state.wake();
+                    return true;
+                }
+            }
+            return false;
+        };
+        if(try_idle(begin, end)) return;
+        if(try_idle(0, begin) || try_idle(end, thread_states.length())) return;
+
         // All queues more or less busy, choose next from low discrepancy sequence
-        u64 i = static_cast<u64>(sequence.incr() * Math::PHI32) % thread_states.length();
+        u64 first = static_cast<u64>(sequence.incr(Thread::Order::relaxed) * Math::PHI32);
+        u64 i = begin + first % (end - begin);
         Thread_State& state = thread_states[i];
 
         Thread::Lock lock(state.mut);
-        state.jobs.push(move(job));
-        state.cond.signal();
+        state.push(move(job), priority);
+        state.wake();
     }
 
-    void enqueue_event(Event event, Handle<> job) noexcept {
+    void enqueue_event(Event event, Handle<> job, Priority priority) noexcept {
         Thread::Lock lock(events_mut);
-        events_to_enqueue.emplace(move(event), move(job));
+        events_to_enqueue.emplace(move(event), Event_Job{move(job), priority});
         pending_events[0].signal();
     }
 
     void do_work(u64 thread_idx) noexcept {
         Thread_State& state = thread_states[thread_idx];
         for(;;) {
+            if(idle == Idle::spin_then_park) {
+                for(u64 i = 0; i < IDLE_SPINS && state.empty() && !shutdown.load(); i++) {
+                    Thread::pause();
+                }
+            }
+
             Handle<> job;
+            if(state.empty() && !shutdown.load() && steal(thread_idx, job)) {
+                job.handle.resume();
+                continue;
+            }
+
+            // Free anything this worker retired before it goes to sleep.
+            if(state.empty() && Epoch::pending() > 0) Epoch::collect();
+
             {
                 Thread::Lock lock(state.mut);
 
-                while(state.jobs.empty() && !shutdown.load()) {
+                while(state.empty() && !shutdown.load()) {
+                    state.parked = true;
                     state.cond.wait(state.mut);
+                    state.parked = false;
                 }
                 if(shutdown.load()) return;
 
-                job = move(state.jobs.front());
-                state.jobs.pop();
+                job = state.pop();
             }
             job.handle.resume();
         }
     }
 
+    // Takes a queued job from a busy worker, trying peers on this worker's NUMA node before
+    // the other nodes so the job stays near the memory it was using.
+    [[nodiscard]] bool steal(u64 thread_idx, Handle<>& job) noexcept {
+        auto try_steal = [&](u64 first, u64 last) {
+            for(u64 i = first; i < last; i++) {
+                Thread_State& victim = thread_states[i];
+                // Race on empty
+                if(i == thread_idx || victim.empty()) continue;
+
+                Thread::Lock lock(victim.mut);
+                if(victim.empty()) continue;
+                job = victim.steal();
+                return true;
+            }
+            return false;
+        };
+        u64 begin = thread_states[thread_idx].peers_begin;
+        u64 end = thread_states[thread_idx].peers_end;
+        return try_steal(begin, end) || try_steal(0, begin) ||
+               try_steal(end, thread_states.length());
+    }
+
     void do_events() noexcept {
         for(;;) {
             u64 idx = Event::wait_any(Slice<Event>{pending_events});
@@ -164,9 +424,9 @@ private:
             if(idx == 0) {
                 if(shutdown.load()) return;
 
-                for(auto& [event, state] : events_to_enqueue) {
+                for(auto& [event, job] : events_to_enqueue) {
                     pending_events.push(move(event));
-                    pending_event_jobs.push(move(state));
+                    pending_event_jobs.push(move(job));
                 }
                 events_to_enqueue.clear();
 
@@ -181,32 +441,98 @@ private:
                 pending_events.pop();
                 pending_event_jobs.pop();
 
-                enqueue(job);
+                enqueue(job.job, job.priority);
             }
         }
     }
 
-    Thread::Atomic shutdown, sequence;
+    Thread::Atomic<bool> shutdown;
+    Thread::Atomic<u64> sequence;
+    Idle idle = Idle::spin_then_park;
 
     struct Thread_State {
         Thread::Mutex mut;
         Thread::Cond cond;
-        Queue<Handle<>, A> jobs;
+        Array<Queue<Handle<>, A>, PRIORITIES> jobs;
+        // Written under mut, read without it by enqueue and spinning workers.
+        Thread::Atomic<u64> length;
+        u64 streak = 0;
+        u64 peers_begin = 0;
+        u64 peers_end = 0;
+        bool parked = false;
+
+        [[nodiscard]] bool empty() const noexcept {
+            return length.load(Thread::Order::relaxed) == 0;
+        }
+
+        void push(Handle<> job, Priority priority) noexcept {
+            jobs[static_cast<u64>(priority)].push(move(job));
+            length.incr(Thread::Order::relaxed);
+        }
+
+        // Must hold mut. A spinning or busy worker will find the job without a signal.
+        void wake() noexcept {
+            if(parked) cond.signal();
+        }
+
+        [[nodiscard]] Handle<> pop() noexcept {
+            assert(!empty());
+            u64 high = PRIORITIES - 1;
+            while(jobs[high].empty()) high--;
+            u64 low = 0;
+            while(jobs[low].empty()) low++;
+
+            // Higher lanes preempt lower ones at every suspension point, but not forever.
+            u64 lane = high;
+            if(low < high && ++streak > STARVATION_LIMIT) {
+                lane = low;
+            }
+            if(lane == low) streak = 0;
+
+            Handle<> job = move(jobs[lane].front());
+            jobs[lane].pop();
+            length.decr(Thread::Order::relaxed);
+            return job;
+        }
+
+        // Must hold mut. Takes the oldest job in the highest non-empty lane for another
+        // worker, leaving the owner's starvation streak alone.
+        [[nodiscard]] Handle<> steal() noexcept {
+            assert(!empty());
+            u64 lane = PRIORITIES - 1;
+            while(jobs[lane].empty()) lane--;
+
+            Handle<> job = move(jobs[lane].front());
+            jobs[lane].pop();
+            length.decr(Thread::Order::relaxed);
+            return job;
+        }
     };
     Vec<Thread_State, A> thread_states;
     Vec<Thread::Thread<A>, A> threads;
 
+    // Jobs waiting on kernel events keep their lane for when the event fires.
+    struct Event_Job {
+        Handle<> job;
+        Priority priority = Priority::normal;
+    };
+
     Vec<Event, A> pending_events;
-    Vec<Handle<>, A> pending_event_jobs;
-    Vec<Pair<Event, Handle<>>, A> events_to_enqueue;
+    Vec<Event_Job, A> pending_event_jobs;
+    Vec<Pair<Event, Event_Job>, A> events_to_enqueue;
 
     Thread::Thread<A> event_thread;
     Thread::Mutex events_mut;
 
+    static inline thread_local Pool* this_pool = null;
+    static inline thread_local u64 this_worker = 0;
+
     template<Allocator>
     friend struct Schedule;
     template<Allocator>
     friend struct Schedule_Event;
+    template<Allocator>
+    friend struct detail::Waiter;
 };
 
 } // namespace rpp::Async
@@ -0,0 +1,52 @@
+
+#include "../base.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rpp {
+
+[[nodiscard]] u64 sys_page_size() noexcept {
+    static u64 page_size = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    return page_size;
+}
+
+constexpr u64 HUGE_PAGE_SIZE = Math::MB(2);
+
+[[nodiscard]] void* sys_alloc_huge(u64 size) noexcept {
+    if(size < HUGE_PAGE_SIZE) return sys_alloc(size);
+    // Aligned and rounded to whole huge pages so the kernel can back all of it with them.
+    // Hugetlbfs pages are usually not reserved, so ask for transparent huge pages instead.
+    void* ret = sys_alloc_aligned(Math::align(size, HUGE_PAGE_SIZE), HUGE_PAGE_SIZE);
+    madvise(ret, Math::align(size, HUGE_PAGE_SIZE), MADV_HUGEPAGE);
+    return ret;
+}
+
+[[nodiscard]] void* sys_reserve(u64 size) noexcept {
+    void* ret = mmap(null, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(ret == MAP_FAILED) {
+        die("Failed to reserve % bytes: %", size, Log::sys_error());
+    }
+    return ret;
+}
+
+void sys_commit(void* mem, u64 size) noexcept {
+    if(mprotect(mem, size, PROT_READ | PROT_WRITE)) {
+        die("Failed to commit % bytes: %", size, Log::sys_error());
+    }
+}
+
+void sys_decommit(void* mem, u64 size) noexcept {
+    // Drop the pages first so the range reads back as zeros if it is committed again.
+    if(madvise(mem, size, MADV_DONTNEED) || mprotect(mem, size, PROT_NONE)) {
+        die("Failed to decommit % bytes: %", size, Log::sys_error());
+    }
+}
+
+void sys_release(void* mem, u64 size) noexcept {
+    if(munmap(mem, size)) {
+        die("Failed to release % bytes: %", size, Log::sys_error());
+    }
+}
+
+} // namespace rpp
@@ -1,22 +1,25 @@
 
 #include "../async.h"
 
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
 namespace rpp::Async {
 
-Event::Event() noexcept {
+[[nodiscard]] Event Event::make_sys() noexcept {
     int event = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
     if(event == -1) {
         die("Failed to create event: %", Log::sys_error());
     }
-    fd = event;
-    mask = EPOLLIN;
+    return Event{event, EPOLLIN};
 }
 
 Event::Event(Event&& other) noexcept {
+    uptr head = other.state.exchange(0, Thread::Order::relaxed);
+    assert(head == 0 || head == SIGNALED);
+    state.store(head, Thread::Order::relaxed);
     fd = other.fd;
     other.fd = -1;
     mask = other.mask;
@@ -25,6 +28,9 @@ Event::Event(Event&& other) noexcept {
 
 Event& Event::operator=(Event&& other) noexcept {
     this->~Event();
+    uptr head = other.state.exchange(0, Thread::Order::relaxed);
+    assert(head == 0 || head == SIGNALED);
+    state.store(head, Thread::Order::relaxed);
     fd = other.fd;
     other.fd = -1;
     mask = other.mask;
@@ -32,20 +38,19 @@ Event& Event::operator=(Event&& other) noexcept {
     return *this;
 }
 
-Event::~Event() noexcept {
-    if(fd != -1) {
-        int ret = close(fd);
-        assert(ret == 0);
-    }
+void Event::close_sys() noexcept {
+    int ret = close(fd);
+    assert(ret == 0);
     fd = -1;
     mask = 0;
 }
 
 [[nodiscard]] Event Event::of_sys(i32 fd, i32 mask) noexcept {
+    assert(fd != -1);
     return Event{fd, mask};
 }
 
-void Event::signal() const noexcept {
+void Event::signal_sys() noexcept {
     u64 value = 1;
     int ret = write(fd, &value, sizeof(value));
     if(ret == -1) {
@@ -53,7 +58,7 @@ void Event::signal() const noexcept {
     }
 }
 
-void Event::reset() const noexcept {
+void Event::reset_sys() noexcept {
     u64 value = 0;
     int ret = read(fd, &value, sizeof(value));
     if(ret == -1) {
@@ -61,8 +66,13 @@ void Event::reset() const noexcept {
     }
 }
 
-[[nodiscard]] bool Event::try_wait() const noexcept {
-    return false;
+[[nodiscard]] bool Event::try_wait_sys() const noexcept {
+    pollfd pfd = {fd, static_cast<short>(mask), 0};
+    int ret = poll(&pfd, 1, 0);
+    if(ret == -1) {
+        die("Failed to check event ready: %", Log::sys_error());
+    }
+    return ret > 0;
 }
 
 [[nodiscard]] u64 Event::wait_any(Slice<Event> events) noexcept {
@@ -73,6 +83,7 @@ void Event::reset() const noexcept {
     }
 
     for(auto& event : events) {
+        assert(event.is_sys());
         epoll_event ev;
         ev.events = event.mask;
         ev.data.fd = event.fd;
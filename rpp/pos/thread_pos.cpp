@@ -4,7 +4,9 @@
 #include <immintrin.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <linux/futex.h>
+#include <stdio.h>
 #include <string.h>
 #include <sys/syscall.h>
 #include <unistd.h>
@@ -55,6 +57,92 @@ void pause() noexcept {
     return static_cast<u64>(ret);
 }
 
+[[nodiscard]] static String_View read_sys(const char* path, u8* buffer, u64 size) noexcept {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd == -1) return String_View{};
+    ssize_t ret = read(fd, buffer, size);
+    close(fd);
+    if(ret <= 0) return String_View{};
+    return String_View{buffer, static_cast<u64>(ret)};
+}
+
+[[nodiscard]] static Opt<u64> parse_sys_u64(String_View text) noexcept {
+    u64 value = 0, i = 0;
+    for(; i < text.length() && text[i] >= '0' && text[i] <= '9'; i++) {
+        value = value * 10 + (text[i] - '0');
+    }
+    if(i == 0) return {};
+    return Opt<u64>{value};
+}
+
+// Parses the kernel's cpulist format, e.g. "0-3,8-11".
+template<typename F>
+static void iterate_sys_list(String_View text, F&& f) noexcept {
+    u64 i = 0;
+    auto number = [&]() {
+        u64 value = 0;
+        for(; i < text.length() && text[i] >= '0' && text[i] <= '9'; i++) {
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    };
+    while(i < text.length() && text[i] >= '0' && text[i] <= '9') {
+        u64 first = number();
+        u64 last = first;
+        if(i < text.length() && text[i] == '-') {
+            i++;
+            last = number();
+        }
+        for(u64 value = first; value <= last; value++) {
+            f(value);
+        }
+        if(i < text.length() && text[i] == ',') i++;
+    }
+}
+
+[[nodiscard]] Vec<Cpu, Alloc> topology() noexcept {
+    constexpr u64 buffer_size = 4096;
+    u8 buffer[buffer_size];
+    char path[128];
+
+    Vec<Cpu, Alloc> cpus;
+
+    String_View online = read_sys("/sys/devices/system/cpu/online", buffer, buffer_size);
+    iterate_sys_list(online, [&](u64 id) { cpus.push(Cpu{id, id, 0, 0}); });
+    if(cpus.empty()) {
+        for(u64 id = 0; id < hardware_threads(); id++) {
+            cpus.push(Cpu{id, id, 0, 0});
+        }
+    }
+
+    for(auto& cpu : cpus) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%lu/topology/core_id", cpu.id);
+        if(auto core = parse_sys_u64(read_sys(path, buffer, buffer_size))) {
+            cpu.core = *core;
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%lu/topology/physical_package_id",
+                 cpu.id);
+        if(auto package = parse_sys_u64(read_sys(path, buffer, buffer_size))) {
+            cpu.package = *package;
+        }
+    }
+
+    Vec<u64, Alloc> nodes;
+    iterate_sys_list(read_sys("/sys/devices/system/node/online", buffer, buffer_size),
+                     [&](u64 node) { nodes.push(node); });
+
+    for(u64 node : nodes) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%lu/cpulist", node);
+        iterate_sys_list(read_sys(path, buffer, buffer_size), [&](u64 id) {
+            for(auto& cpu : cpus) {
+                if(cpu.id == id) cpu.node = node;
+            }
+        });
+    }
+
+    return cpus;
+}
+
 void set_priority(Priority p) noexcept {
 
     pthread_t id = pthread_self();
@@ -120,118 +208,57 @@ void set_affinity(u64 core) noexcept {
     }
 }
 
+// The flag is 0 while unsignaled, FLAG_PARKED once a thread may be sleeping on it, and
+// FLAG_SIGNALED afterwards. signal only enters the kernel if someone parked.
+static constexpr i32 FLAG_SIGNALED = 1;
+static constexpr i32 FLAG_PARKED = 2;
+
 void Flag::block() noexcept {
-    while(__atomic_load_n(&value_, __ATOMIC_SEQ_CST) == 0) {
-        int ret = syscall(SYS_futex, &value_, FUTEX_WAIT, 0, NULL, NULL, 0);
-        if(ret == -1 && errno != EAGAIN) {
+    for(;;) {
+        i32 value = __atomic_load_n(&value_, __ATOMIC_ACQUIRE);
+        if(value == FLAG_SIGNALED) return;
+        if(value == 0 &&
+           !__atomic_compare_exchange_n(&value_, &value, FLAG_PARKED, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        int ret = syscall(SYS_futex, &value_, FUTEX_WAIT_PRIVATE, FLAG_PARKED, NULL, NULL, 0);
+        if(ret == -1 && errno != EAGAIN && errno != EINTR) {
             die("Failed to wait on futex: %", error(errno));
         }
     }
 }
 
 void Flag::signal() noexcept {
-    __atomic_exchange_n(&value_, 1, __ATOMIC_SEQ_CST);
-    int ret = syscall(SYS_futex, &value_, FUTEX_WAKE, RPP_INT32_MAX, NULL, NULL, 0);
+    if(__atomic_exchange_n(&value_, FLAG_SIGNALED, __ATOMIC_RELEASE) != FLAG_PARKED) return;
+    int ret = syscall(SYS_futex, &value_, FUTEX_WAKE_PRIVATE, RPP_INT32_MAX, NULL, NULL, 0);
     if(ret == -1) {
         die("Failed to wake futex: %", error(errno));
     }
 }
 
 [[nodiscard]] bool Flag::ready() noexcept {
-    return __atomic_load_n(&value_, __ATOMIC_SEQ_CST) != 0;
+    return __atomic_load_n(&value_, __ATOMIC_ACQUIRE) == FLAG_SIGNALED;
 }
 
-Mutex::Mutex() noexcept {
-    int ret = pthread_mutex_init(&lock_, null);
-    if(ret) {
-        die("Failed to create mutex: %", error(ret));
+void detail::atomic_wait(const void* address, u32 expected) noexcept {
+    int ret = syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+    if(ret == -1 && errno != EAGAIN && errno != EINTR) {
+        die("Failed to wait on futex: %", error(errno));
     }
 }
 
-Mutex::~Mutex() noexcept {
-    int ret = pthread_mutex_destroy(&lock_);
-    if(ret) {
-        die("Failed to destroy mutex: %", error(ret));
-    }
-}
-
-void Mutex::lock() noexcept {
-    int ret = pthread_mutex_lock(&lock_);
-    if(ret) {
-        die("Failed to lock mutex: %", error(ret));
-    }
-}
-
-void Mutex::unlock() noexcept {
-    int ret = pthread_mutex_unlock(&lock_);
-    if(ret) {
-        die("Failed to unlock mutex: %", error(ret));
-    }
-}
-
-[[nodiscard]] bool Mutex::try_lock() noexcept {
-    int ret = pthread_mutex_trylock(&lock_);
-    if(ret == EBUSY)
-        return false;
-    else if(ret)
-        die("Failed to try lock mutex: %", error(ret));
-    return true;
-}
-
-[[nodiscard]] i64 Atomic::load() const noexcept {
-    return __atomic_load_n(&value_, __ATOMIC_SEQ_CST);
-}
-
-i64 Atomic::incr() noexcept {
-    return __atomic_fetch_add(&value_, 1, __ATOMIC_SEQ_CST) + 1;
-}
-
-i64 Atomic::decr() noexcept {
-    return __atomic_fetch_sub(&value_, 1, __ATOMIC_SEQ_CST) - 1;
-}
-
-i64 Atomic::exchange(i64 value) noexcept {
-    return __atomic_exchange_n(&value_, value, __ATOMIC_SEQ_CST);
-}
-
-[[nodiscard]] i64 Atomic::compare_and_swap(i64 compare_with, i64 set_to) noexcept {
-    __atomic_compare_exchange_n(&value_, &compare_with, set_to, false, __ATOMIC_SEQ_CST,
-                                __ATOMIC_SEQ_CST);
-    return compare_with;
-}
-
-Cond::Cond() noexcept {
-    int ret = pthread_cond_init(&cond_, null);
-    if(ret) {
-        die("Failed to create condvar: %", error(ret));
-    }
-}
-
-Cond::~Cond() noexcept {
-    int ret = pthread_cond_destroy(&cond_);
-    if(ret) {
-        die("Failed to destroy condvar: %", error(ret));
-    }
-}
-
-void Cond::wait(Mutex& mut) noexcept {
-    int ret = pthread_cond_wait(&cond_, &mut.lock_);
-    if(ret) {
-        die("Failed to wait on cond: %", error(ret));
-    }
-}
-
-void Cond::signal() noexcept {
-    int ret = pthread_cond_signal(&cond_);
-    if(ret) {
-        die("Failed to signal cond: %", error(ret));
+void detail::atomic_notify_one(const void* address) noexcept {
+    int ret = syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    if(ret == -1) {
+        die("Failed to wake futex: %", error(errno));
     }
 }
 
-void Cond::broadcast() noexcept {
-    int ret = pthread_cond_broadcast(&cond_);
-    if(ret) {
-        die("Failed to broadcast cond: %", error(ret));
+void detail::atomic_notify_all(const void* address) noexcept {
+    int ret = syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, RPP_INT32_MAX, NULL, NULL, 0);
+    if(ret == -1) {
+        die("Failed to wake futex: %", error(errno));
     }
 }
 
@@ -1,4 +1,5 @@
 
+#include "alloc_pos.cpp"
 #include "async_pos.cpp"
 #include "asyncio_pos.cpp"
 #include "files_pos.cpp"
@@ -18,7 +18,8 @@ constexpr bool DO_PROFILE = true;
 #endif
 
 #define RPP_TRACE2(COUNTER) __profile_##COUNTER
-#define RPP_TRACE1(NAME, COUNTER) if(::rpp::Profile::Scope RPP_TRACE2(COUNTER){String_View{NAME}})
+#define RPP_TRACE1(NAME, COUNTER)                                                                  \
+    if(::rpp::Profile::Scope RPP_TRACE2(COUNTER){::rpp::Intern::get<NAME>()})
 
 #define Trace(NAME) RPP_TRACE1(NAME, __COUNTER__)
 
@@ -31,10 +32,11 @@ struct Profile {
 
     static void enter(Log::Location l) noexcept;
     static void enter(String_View l) noexcept;
+    static void enter(Intern::Symbol l) noexcept;
     static void exit() noexcept;
 
     struct Alloc {
-        String_View name;
+        Intern::Symbol name;
         void* address = null;
         u64 size = 0; // 0 means free
     };
@@ -51,6 +53,9 @@ struct Profile {
         Scope(String_View name) noexcept {
             Profile::enter(move(name));
         }
+        Scope(Intern::Symbol name) noexcept {
+            Profile::enter(name);
+        }
         ~Scope() noexcept {
             Profile::exit();
         }
@@ -62,15 +67,19 @@ struct Profile {
 
     struct Timing_Node {
         Log::Location loc;
+        // Interned function name. Named scopes are matched by it alone.
+        Intern::Symbol name;
         Time_Point begin = 0, end = 0;
         Time_Point self_time = 0, heir_time = 0;
         u64 calls = 0;
         u64 parent = 0;
-        Vec<u64, Mhidden> children;
+        Small_Vec<u64, 8, Mhidden> children;
 
-        [[nodiscard]] static Timing_Node make(Log::Location loc, u64 parent) noexcept {
+        [[nodiscard]] static Timing_Node make(Log::Location loc, Intern::Symbol name,
+                                              u64 parent) noexcept {
             Timing_Node ret;
             ret.loc = move(loc);
+            ret.name = name;
             ret.parent = parent;
             ret.begin = timestamp();
             ret.calls = 1;
@@ -80,7 +89,7 @@ struct Profile {
 
     template<typename F>
     static void iterate_timings(F&& f) noexcept {
-        Thread::Lock lock(threads_lock);
+        Thread::Read_Lock lock(threads_lock);
 
         for(auto& entry : threads) {
 
@@ -125,6 +134,9 @@ private:
         [[nodiscard]] Time_Point begin() noexcept;
         void end() noexcept;
         void enter(Log::Location loc) noexcept;
+        void enter(Intern::Symbol name) noexcept;
+        void repeat(u64 child_idx) noexcept;
+        void push(Log::Location loc, Intern::Symbol name) noexcept;
         void exit() noexcept;
         void compute_self_times(u64 idx) noexcept;
 
@@ -152,12 +164,13 @@ private:
         Queue<Frame_Profile, Mhidden> frames;
     };
 
-    static inline Thread::Mutex threads_lock;
+    static inline Thread::RwLock threads_lock;
     static inline Thread::Mutex allocs_lock;
     static inline Thread::Mutex finalizers_lock;
     static inline thread_local Thread_Profile this_thread;
     static inline Map<Thread::Id, Ref<Thread_Profile>, Mhidden> threads;
-    static inline Map<String_View, Alloc_Profile, Mhidden> allocs;
+    static inline Map<Intern::Symbol, Alloc_Profile, Mhidden> allocs;
+    static inline bool allocs_finalized = false;
     static inline Vec<Function<void()>, Mhidden> finalizers;
 };
 
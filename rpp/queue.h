@@ -12,7 +12,7 @@ struct Queue {
 
     Queue() noexcept = default;
     explicit Queue(u64 capacity) noexcept {
-        data_ = reinterpret_cast<T*>(A::alloc(capacity * sizeof(T)));
+        data_ = reinterpret_cast<T*>(Backing::alloc(capacity * sizeof(T)));
         length_ = 0;
         last_ = 0;
         capacity_ = capacity;
@@ -53,7 +53,7 @@ struct Queue {
 
     ~Queue() noexcept {
         clear();
-        A::free(data_);
+        Backing::free(data_);
         data_ = null;
         capacity_ = 0;
     }
@@ -95,7 +95,30 @@ struct Queue {
     void reserve(u64 new_capacity) noexcept {
         if(new_capacity <= capacity_) return;
 
-        T* new_data = reinterpret_cast<T*>(A::alloc(new_capacity * sizeof(T)));
+        if constexpr(Trivially_Movable<T> && Reallocating_Allocator<Backing>) {
+            if(data_) {
+                data_ = reinterpret_cast<T*>(Backing::realloc(data_, new_capacity * sizeof(T)));
+                if(last_ == 0) {
+                    // The elements end at the old capacity, so they are already contiguous.
+                    if(length_) last_ = capacity_;
+                } else if(length_ > last_) {
+                    // Wrapped: move the smaller segment. The newer one goes after the old end
+                    // if it fits, otherwise the older one goes to the end of the new buffer.
+                    u64 first = length_ - last_;
+                    if(last_ < first && last_ < new_capacity - capacity_) {
+                        Libc::memcpy(data_ + capacity_, data_, sizeof(T) * last_);
+                        last_ += capacity_;
+                    } else {
+                        Libc::memmove(data_ + new_capacity - first, data_ + capacity_ - first,
+                                      sizeof(T) * first);
+                    }
+                }
+                capacity_ = new_capacity;
+                return;
+            }
+        }
+
+        T* new_data = reinterpret_cast<T*>(Backing::alloc(new_capacity * sizeof(T)));
         T* start = data_ + last_ - length_;
 
         if constexpr(Trivially_Movable<T>) {
@@ -123,7 +146,7 @@ struct Queue {
             }
         }
 
-        A::free(data_);
+        Backing::free(data_);
         last_ = length_;
         capacity_ = new_capacity;
         data_ = new_data;
@@ -326,6 +349,8 @@ struct Queue {
     }
 
 private:
+    using Backing = Aligned_Adaptor<A, alignof(T)>;
+
     [[nodiscard]] u64 start_idx() const noexcept {
         u64 idx = last_ - length_;
         return idx >= capacity_ ? idx + capacity_ : idx;
@@ -6,14 +6,27 @@
 
 namespace rpp {
 
+template<Allocator A, u64 Buckets, u64 Bias>
+struct Concurrent_Range_Allocator;
+
+// Two-level segregated fit: free blocks are binned by the power of two of their size (the bucket),
+// then by one of Slots linear subdivisions of that range. A bitmap per level makes finding a
+// suitable non-empty bin a couple of bit scans, so allocate and free take constant time.
 template<Allocator A = Mdefault, u64 Buckets = 24, u64 Bias = 8>
 struct Range_Allocator {
 
+    constexpr static u64 Slot_Bits = 4;
+    constexpr static u64 Slots = 1ull << Slot_Bits;
+
+    static_assert(Buckets > 0 && Buckets < 64);
+    static_assert(Bias >= Slot_Bits);
+
     Range_Allocator() noexcept = default;
-    explicit Range_Allocator(u64 heap_size) noexcept {
+    explicit Range_Allocator(u64 heap_size, u64 base = 0) noexcept {
         assert(heap_size);
-        Block* primary = blocks.make(Block{0, 0, heap_size, null, null});
+        Block* primary = blocks.make(Block{base, base, heap_size, null, null});
         insert_free_block(primary);
+        first = primary;
         stats.free_blocks = 1;
         stats.free_size = heap_size;
         stats.total_capacity = heap_size;
@@ -37,7 +50,15 @@ struct Range_Allocator {
         stats = src.stats;
         src.stats = {};
         free_blocks = src.free_blocks;
-        for(u64 i = 0; i < Buckets; i++) src.free_blocks[i] = null;
+        bucket_map = src.bucket_map;
+        slot_maps = src.slot_maps;
+        for(u64 i = 0; i < Buckets * Slots; i++) src.free_blocks[i] = null;
+        for(u64 i = 0; i < Buckets; i++) src.slot_maps[i] = 0;
+        src.bucket_map = 0;
+        first = src.first;
+        cursor = src.cursor;
+        src.first = null;
+        src.cursor = null;
         blocks = move(src.blocks);
 
         return *this;
@@ -64,9 +85,11 @@ struct Range_Allocator {
         Block* prev_block;
         Block* next_free;
         Block* prev_free;
+        u64 alignment = 1;
         bool free;
 
         friend struct Range_Allocator<A, Buckets, Bias>;
+        friend struct Concurrent_Range_Allocator<A, Buckets, Bias>;
     };
     using Range = Block*;
 
@@ -76,36 +99,19 @@ struct Range_Allocator {
 
         Thread::Lock lock(mutex);
 
-        // Find list that contains blocks of size 2^log2(size) to 2*2^log2(size)
-        u8 idx = size_to_idx(size);
-        while(idx < Buckets && !free_blocks[idx]) {
-            idx++;
-        }
-        if(idx == Buckets) {
-            return {};
-        }
-
-        // Find block of size that can fit this allocation
-        Block* block = free_blocks[idx];
-        u64 padding = 0;
-        while(block) {
-            padding = Math::align(block->start, alignment) - block->start;
-            if(block->size >= size + padding) {
-                break;
-            }
-            block = block->next_free;
-            while(!block && idx < Buckets - 1) {
-                block = free_blocks[++idx];
-            }
-        }
-
+        // Any block in the bin found for size + alignment - 1 fits regardless of its start.
+        // If there is none, fall back to searching the bins that may hold a fit.
+        Block* block = find_good_fit(size + alignment - 1);
+        if(!block) block = find_first_fit(size, alignment);
         if(!block) {
             return {};
         }
+        u64 padding = Math::align(block->start, alignment) - block->start;
 
         // Remove block from free list
         remove_free_block(block);
         block->offset = block->start + padding;
+        block->alignment = alignment;
 
         // Split block
         if(block->size > size + padding) {
@@ -154,6 +160,8 @@ struct Range_Allocator {
             prev->next_block = next;
             if(next) next->prev_block = prev;
 
+            // Keep the defragmentation cursor off destroyed blocks.
+            if(cursor == block) cursor = prev;
             blocks.destroy(block);
             stats.free_blocks -= 1;
 
@@ -171,11 +179,15 @@ struct Range_Allocator {
 
             stats.free_blocks -= 1;
 
+            if(cursor == next) cursor = block;
             blocks.destroy(next);
         }
 
         insert_free_block(block);
 
+        // Rewind defragmentation to the new hole.
+        if(cursor && block->start < cursor->start) cursor = block;
+
         stats.free_size += free_size;
         stats.allocated_size -= free_size;
         stats.allocated_blocks -= 1;
@@ -185,6 +197,97 @@ struct Range_Allocator {
         stats.total_free_size += free_size;
     }
 
+    // Incrementally compacts live ranges toward the start of the heap, making at most max_moves
+    // moves. Each moved range keeps its identity and alignment; relocate(range, from) is called
+    // after the move so the owner can copy range->length() bytes from offset from to
+    // range->offset. The source and destination may overlap. relocate runs under the allocator's
+    // lock and must not call back into it. Returns true once no hole is followed by a live range.
+    template<typename F>
+        requires Invocable<F, Range, u64>
+    [[nodiscard]] bool defragment(F&& relocate, u64 max_moves) noexcept {
+
+        Thread::Lock lock(mutex);
+
+        Block* block = cursor ? cursor : first;
+        u64 moves = 0;
+        while(block && moves < max_moves) {
+
+            // Adjacent holes are always merged, so a hole is followed by a live range or nothing.
+            while(block && !block->free) block = block->next_block;
+            if(!block || !block->next_block) {
+                cursor = block;
+                return true;
+            }
+
+            Block* hole = block;
+            Block* live = hole->next_block;
+            u64 from = live->offset;
+            u64 to = Math::align(hole->start, live->alignment);
+            u64 size = to + live->length() - hole->start;
+            u64 grown = size - live->size;
+            u64 remaining = hole->size + live->size - size;
+
+            remove_free_block(hole);
+
+            stats.free_size -= grown;
+            stats.allocated_size += grown;
+            stats.high_water = Math::max(stats.high_water, stats.allocated_size);
+            stats.total_alloc_size += grown;
+
+            if(remaining == 0) {
+                // The hole is smaller than the range's alignment: fold it into the padding.
+                live->start = hole->start;
+                live->size = size;
+                live->prev_block = hole->prev_block;
+                if(hole->prev_block) hole->prev_block->next_block = live;
+                if(first == hole) first = live;
+                blocks.destroy(hole);
+                stats.free_blocks -= 1;
+                block = live;
+                continue;
+            }
+
+            // Swap the two blocks, leaving the hole after the range.
+            Block* prev = hole->prev_block;
+            Block* next = live->next_block;
+
+            live->start = hole->start;
+            live->offset = to;
+            live->size = size;
+            live->prev_block = prev;
+            live->next_block = hole;
+            if(prev) prev->next_block = live;
+            if(first == hole) first = live;
+
+            hole->start = live->start + size;
+            hole->size = remaining;
+            hole->prev_block = live;
+            hole->next_block = next;
+            if(next) next->prev_block = hole;
+
+            if(next && next->free) {
+                remove_free_block(next);
+                hole->size += next->size;
+                hole->next_block = next->next_block;
+                if(next->next_block) next->next_block->prev_block = hole;
+                blocks.destroy(next);
+                stats.free_blocks -= 1;
+            }
+
+            insert_free_block(hole);
+
+            relocate(live, from);
+            moves += 1;
+            stats.total_relocations += 1;
+            stats.total_relocated_size += live->length();
+
+            block = hole;
+        }
+
+        cursor = block;
+        return false;
+    }
+
     struct Stats {
         u64 free_size = 0;
         u64 allocated_size = 0;
@@ -192,12 +295,21 @@ struct Range_Allocator {
         u64 allocated_blocks = 0;
         u64 bucket_sizes[Buckets] = {};
         u64 high_water = 0;
+        u64 largest_free_size = 0;
 
         u64 total_frees = 0;
         u64 total_allocs = 0;
         u64 total_free_size = 0;
         u64 total_alloc_size = 0;
         u64 total_capacity = 0;
+        u64 total_relocations = 0;
+        u64 total_relocated_size = 0;
+
+        // Zero when all free space is one block, approaching one as it splinters.
+        [[nodiscard]] f64 fragmentation() const noexcept {
+            if(free_size == 0) return 0.0;
+            return 1.0 - static_cast<f64>(largest_free_size) / static_cast<f64>(free_size);
+        }
 
         void assert_clear() noexcept {
             assert(total_allocs == total_frees);
@@ -213,44 +325,137 @@ struct Range_Allocator {
     };
 
     [[nodiscard]] Stats statistics() noexcept {
-        return stats;
+        Thread::Lock lock(mutex);
+        Stats result = stats;
+        result.largest_free_size = largest_free_size();
+        return result;
     }
 
 private:
     Thread::Mutex mutex;
     Free_List<Block, A> blocks;
-    Array<Block*, Buckets> free_blocks;
+    Array<Block*, Buckets * Slots> free_blocks;
+    Array<u64, Buckets> slot_maps;
+    u64 bucket_map = 0;
     Stats stats;
 
-    [[nodiscard]] u8 size_to_idx(u64 size) noexcept {
-        u64 idx = Math::log2(size);
-        idx = idx >= Bias ? idx - Bias : 0;
-        return static_cast<u8>(Math::min(idx, Buckets - 1ul));
+    // Physically first block, which merging never destroys, and where defragment resumes.
+    Block* first = null;
+    Block* cursor = null;
+
+    struct Index {
+        u64 bucket;
+        u64 slot;
+    };
+
+    // Bucket zero evenly divides [0, 2^Bias); bucket b > 0 divides [2^(Bias+b-1), 2^(Bias+b)).
+    // The last bucket also holds every larger block.
+    [[nodiscard]] static Index size_to_index(u64 size) noexcept {
+        if(size < (1ull << Bias)) {
+            return Index{0, size >> (Bias - Slot_Bits)};
+        }
+        u64 log = Math::log2(size);
+        u64 bucket = log - Bias + 1;
+        if(bucket >= Buckets) {
+            return Index{Buckets - 1, Slots - 1};
+        }
+        return Index{bucket, (size >> (log - Slot_Bits)) & (Slots - 1)};
+    }
+
+    // Finds the first non-empty bin at or above index.
+    [[nodiscard]] Opt<Index> find_bin(Index index) noexcept {
+        u64 slots = slot_maps[index.bucket] & (~0ull << index.slot);
+        if(slots) {
+            return Opt<Index>{Index{index.bucket, Math::cttz(slots)}};
+        }
+        u64 buckets = bucket_map & (~0ull << (index.bucket + 1));
+        if(!buckets) {
+            return {};
+        }
+        u64 bucket = Math::cttz(buckets);
+        return Opt<Index>{Index{bucket, Math::cttz(slot_maps[bucket])}};
+    }
+
+    // Constant time: rounds size up to the next bin boundary, so the head of the first non-empty
+    // bin from there is large enough. Only the unbounded last bin has to be checked.
+    [[nodiscard]] Block* find_good_fit(u64 size) noexcept {
+        u64 rounded = size;
+        if(size >= (1ull << Bias)) {
+            rounded += (1ull << (Math::log2(size) - Slot_Bits)) - 1;
+        } else {
+            rounded += (1ull << (Bias - Slot_Bits)) - 1;
+        }
+        Opt<Index> index = find_bin(size_to_index(rounded));
+        if(!index) return null;
+        Block* block = free_blocks[index->bucket * Slots + index->slot];
+        if(block->size < size) return null;
+        return block;
+    }
+
+    // Linear in the number of free blocks: only used when no bin is guaranteed to fit, e.g. for
+    // large alignments or when the heap is nearly full.
+    [[nodiscard]] Block* find_first_fit(u64 size, u64 alignment) noexcept {
+        Opt<Index> index = find_bin(size_to_index(size));
+        while(index) {
+            for(Block* block = free_blocks[index->bucket * Slots + index->slot]; block;
+                block = block->next_free) {
+                u64 padding = Math::align(block->start, alignment) - block->start;
+                if(block->size >= size + padding) return block;
+            }
+            if(index->slot + 1 < Slots) {
+                index = find_bin(Index{index->bucket, index->slot + 1});
+            } else if(index->bucket + 1 < Buckets) {
+                index = find_bin(Index{index->bucket + 1, 0});
+            } else {
+                index = Opt<Index>{};
+            }
+        }
+        return null;
+    }
+
+    // The largest block is in the highest non-empty bin, so only that bin is searched.
+    [[nodiscard]] u64 largest_free_size() noexcept {
+        if(!bucket_map) return 0;
+        u64 bucket = Math::log2(bucket_map);
+        u64 slot = Math::log2(slot_maps[bucket]);
+        u64 largest = 0;
+        for(Block* block = free_blocks[bucket * Slots + slot]; block; block = block->next_free) {
+            largest = Math::max(largest, block->size);
+        }
+        return largest;
     }
 
     void insert_free_block(Block* block) noexcept {
         block->free = true;
-        u8 idx = size_to_idx(block->size);
+        Index index = size_to_index(block->size);
+        Block*& head = free_blocks[index.bucket * Slots + index.slot];
         block->prev_free = null;
-        block->next_free = free_blocks[idx];
-        if(free_blocks[idx]) free_blocks[idx]->prev_free = block;
-        free_blocks[idx] = block;
-        stats.bucket_sizes[idx] += 1;
+        block->next_free = head;
+        if(head) head->prev_free = block;
+        head = block;
+        bucket_map |= 1ull << index.bucket;
+        slot_maps[index.bucket] |= 1ull << index.slot;
+        stats.bucket_sizes[index.bucket] += 1;
     }
 
     void remove_free_block(Block* block) noexcept {
         block->free = false;
-        u8 idx = size_to_idx(block->size);
+        Index index = size_to_index(block->size);
+        Block*& head = free_blocks[index.bucket * Slots + index.slot];
         if(block->prev_free) block->prev_free->next_free = block->next_free;
         if(block->next_free) block->next_free->prev_free = block->prev_free;
-        if(free_blocks[idx] == block) free_blocks[idx] = block->next_free;
+        if(head == block) head = block->next_free;
+        if(!head) {
+            slot_maps[index.bucket] &= ~(1ull << index.slot);
+            if(!slot_maps[index.bucket]) bucket_map &= ~(1ull << index.bucket);
+        }
         block->next_free = null;
         block->prev_free = null;
-        stats.bucket_sizes[idx] -= 1;
+        stats.bucket_sizes[index.bucket] -= 1;
     }
 
     void reset() noexcept {
-        for(u64 i = 0; i < Buckets; i++) {
+        for(u64 i = 0; i < Buckets * Slots; i++) {
             Block* block = free_blocks[i];
             while(block) {
                 Block* next = block->next_free;
@@ -259,8 +464,255 @@ private:
             }
             free_blocks[i] = null;
         }
+        for(u64 i = 0; i < Buckets; i++) slot_maps[i] = 0;
+        bucket_map = 0;
+        first = null;
+        cursor = null;
         blocks.clear();
     }
 };
 
+// Splits the heap into chunks that are handed out to shards, so threads sub-allocate without
+// contending on one lock. Threads are spread over the shards, allocate from their shard's chunks,
+// and refill it from the shared heap a chunk at a time. Requests too large for a chunk go to the
+// shared heap directly. Frees that find the owning shard busy are pushed onto its lock-free
+// remote list, which the shard drains on its next allocation. Chunks that become empty are
+// returned, except for each shard's most recent one.
+template<Allocator A = Mdefault, u64 Buckets = 24, u64 Bias = 8>
+struct Concurrent_Range_Allocator {
+
+    using Heap = Range_Allocator<A, Buckets, Bias>;
+    using Block = typename Heap::Block;
+    using Range = typename Heap::Range;
+    using Stats = typename Heap::Stats;
+
+    explicit Concurrent_Range_Allocator(u64 heap_size, u64 chunk_size,
+                                        u64 n_shards = Thread::hardware_threads()) noexcept
+        : global{heap_size}, chunk_size{chunk_size} {
+        assert(chunk_size && n_shards);
+        chunks.resize((heap_size + chunk_size - 1) / chunk_size);
+        for(u64 i = 0; i < n_shards; i++) {
+            shards.push(Box<Shard, A>::make());
+        }
+    }
+    ~Concurrent_Range_Allocator() noexcept {
+        for(auto& shard : shards) {
+            Chunk* chunk = shard->chunks;
+            while(chunk) {
+                Chunk* next = chunk->next;
+                Pool_Adaptor<A>::destroy(chunk);
+                chunk = next;
+            }
+        }
+    }
+
+    Concurrent_Range_Allocator(const Concurrent_Range_Allocator&) noexcept = delete;
+    Concurrent_Range_Allocator& operator=(const Concurrent_Range_Allocator&) noexcept = delete;
+
+    Concurrent_Range_Allocator(Concurrent_Range_Allocator&&) noexcept = delete;
+    Concurrent_Range_Allocator& operator=(Concurrent_Range_Allocator&&) noexcept = delete;
+
+    [[nodiscard]] Opt<Range> allocate(u64 size, u64 alignment) noexcept {
+
+        assert(size && alignment);
+
+        if(size + alignment - 1 > chunk_size / 2) {
+            return global.allocate(size, alignment);
+        }
+
+        u64 index = thread_index() % shards.length();
+        Shard& shard = *shards[index];
+        Thread::Lock lock(shard.mutex);
+
+        drain(shard);
+
+        for(Chunk* chunk = shard.chunks; chunk; chunk = chunk->next) {
+            if(Opt<Range> range = chunk->heap.allocate(size, alignment)) {
+                chunk->live++;
+                return range;
+            }
+        }
+
+        if(Chunk* chunk = refill(shard, index)) {
+            Opt<Range> range = chunk->heap.allocate(size, alignment);
+            assert(range);
+            chunk->live++;
+            return range;
+        }
+
+        // No whole chunk is left, but the shared heap may still fit this request.
+        return global.allocate(size, alignment);
+    }
+
+    void free(Range range) noexcept {
+
+        // A chunk covers every range that starts inside it, and can't be returned while any of
+        // them are live, so this lookup needs no lock.
+        Chunk* chunk = chunks[range->offset / chunk_size];
+        if(!chunk) {
+            global.free(range);
+            return;
+        }
+
+        Shard& shard = *shards[chunk->shard];
+        if(shard.mutex.try_lock()) {
+            free_local(shard, chunk, range);
+            drain(shard);
+            shard.mutex.unlock();
+            return;
+        }
+
+        Range head = shard.remote.load(Thread::Order::relaxed);
+        for(;;) {
+            range->next_free = head;
+            Range prev = shard.remote.compare_and_swap(head, range, Thread::Order::release);
+            if(prev == head) return;
+            head = prev;
+        }
+    }
+
+    // Completes pending remote frees and returns every empty chunk to the shared heap.
+    void trim() noexcept {
+        for(auto& shard : shards) {
+            Thread::Lock lock(shard->mutex);
+            drain(*shard);
+            Chunk* chunk = shard->chunks;
+            while(chunk) {
+                Chunk* next = chunk->next;
+                if(chunk->live == 0) release(*shard, chunk);
+                chunk = next;
+            }
+        }
+    }
+
+    // Merges the shared heap's counters with each chunk's, so the result describes the ranges
+    // handed out to callers rather than the chunks. Exact only while no other thread is using
+    // the allocator; high_water is measured at chunk granularity.
+    [[nodiscard]] Stats statistics() noexcept {
+        Stats result = global.statistics();
+
+        for(auto& shard : shards) {
+            Thread::Lock lock(shard->mutex);
+            for(Chunk* chunk = shard->chunks; chunk; chunk = chunk->next) {
+                u64 footprint = chunk->range->length() + chunk->range->padding();
+                result.allocated_size -= footprint;
+                result.allocated_blocks -= 1;
+                accumulate(result, chunk->heap.statistics());
+            }
+        }
+
+        Thread::Lock lock(returned_lock);
+        result.total_allocs += returned.total_allocs - refills;
+        result.total_frees += returned.total_frees - releases;
+        result.total_alloc_size += returned.total_alloc_size - refill_size;
+        result.total_free_size += returned.total_free_size - release_size;
+        return result;
+    }
+
+private:
+    struct Chunk {
+        explicit Chunk(Range range, u64 size, u64 shard) noexcept
+            : heap{size, range->offset}, range{range}, shard{shard} {
+        }
+
+        Heap heap;
+        Range range;
+        u64 shard = 0;
+        u64 live = 0;
+        Chunk* next = null;
+    };
+
+    struct Shard {
+        Thread::Mutex mutex;
+        Thread::Atomic<Range> remote;
+        // Most recently refilled first.
+        Chunk* chunks = null;
+    };
+
+    Heap global;
+    u64 chunk_size = 0;
+    Vec<Chunk*, A> chunks;
+    Vec<Box<Shard, A>, A> shards;
+
+    // Counters of chunks that have been returned to the shared heap.
+    Thread::Mutex returned_lock;
+    Stats returned;
+    u64 refills = 0;
+    u64 releases = 0;
+    u64 refill_size = 0;
+    u64 release_size = 0;
+
+    static inline Thread::Atomic<u64> next_thread;
+
+    [[nodiscard]] static u64 thread_index() noexcept {
+        static thread_local u64 index = next_thread.fetch_add(1, Thread::Order::relaxed);
+        return index;
+    }
+
+    [[nodiscard]] Chunk* refill(Shard& shard, u64 index) noexcept {
+        Opt<Range> range = global.allocate(chunk_size, chunk_size);
+        if(!range) return null;
+
+        Chunk* chunk = Pool_Adaptor<A>::template make<Chunk>(*range, chunk_size, index);
+        chunk->next = shard.chunks;
+        shard.chunks = chunk;
+        chunks[(*range)->offset / chunk_size] = chunk;
+
+        Thread::Lock lock(returned_lock);
+        refills += 1;
+        refill_size += (*range)->length() + (*range)->padding();
+        return chunk;
+    }
+
+    void release(Shard& shard, Chunk* chunk) noexcept {
+        Chunk** link = &shard.chunks;
+        while(*link != chunk) link = &(*link)->next;
+        *link = chunk->next;
+        chunks[chunk->range->offset / chunk_size] = null;
+
+        Range range = chunk->range;
+        {
+            Thread::Lock lock(returned_lock);
+            Stats stats = chunk->heap.statistics();
+            returned.total_allocs += stats.total_allocs;
+            returned.total_frees += stats.total_frees;
+            returned.total_alloc_size += stats.total_alloc_size;
+            returned.total_free_size += stats.total_free_size;
+            releases += 1;
+            release_size += range->length() + range->padding();
+        }
+
+        Pool_Adaptor<A>::destroy(chunk);
+        global.free(range);
+    }
+
+    void free_local(Shard& shard, Chunk* chunk, Range range) noexcept {
+        chunk->heap.free(range);
+        if(--chunk->live == 0 && chunk != shard.chunks) release(shard, chunk);
+    }
+
+    void drain(Shard& shard) noexcept {
+        Range range = shard.remote.exchange(null, Thread::Order::acquire);
+        while(range) {
+            Range next = range->next_free;
+            range->next_free = null;
+            free_local(shard, chunks[range->offset / chunk_size], range);
+            range = next;
+        }
+    }
+
+    static void accumulate(Stats& result, const Stats& stats) noexcept {
+        result.free_size += stats.free_size;
+        result.allocated_size += stats.allocated_size;
+        result.free_blocks += stats.free_blocks;
+        result.allocated_blocks += stats.allocated_blocks;
+        for(u64 i = 0; i < Buckets; i++) result.bucket_sizes[i] += stats.bucket_sizes[i];
+        result.largest_free_size = Math::max(result.largest_free_size, stats.largest_free_size);
+        result.total_frees += stats.total_frees;
+        result.total_allocs += stats.total_allocs;
+        result.total_free_size += stats.total_free_size;
+        result.total_alloc_size += stats.total_alloc_size;
+    }
+};
+
 } // namespace rpp
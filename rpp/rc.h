@@ -18,10 +18,10 @@ struct Rc_Data {
 
 template<typename T>
 struct Arc_Data {
-    explicit Arc_Data(Thread::Atomic r) noexcept : references(r) {
+    explicit Arc_Data(u64 r) noexcept : references(r) {
     }
 
-    Thread::Atomic references;
+    Thread::Atomic<u64> references;
     Storage<T> value;
 };
 
@@ -138,14 +138,14 @@ struct Arc {
     template<typename... Args>
         requires Constructable<T, Args...>
     explicit Arc(Args&&... args) noexcept {
-        data_ = A::template make<Data>(Thread::Atomic{1});
+        data_ = A::template make<Data>(static_cast<u64>(1));
         data_->value.construct(forward<Args>(args)...);
     }
 
     template<typename... Args>
     [[nodiscard]] static Arc make(Args&&... args) noexcept {
         Arc ret;
-        ret.data_ = A::template make<Data>(Thread::Atomic{1});
+        ret.data_ = A::template make<Data>(static_cast<u64>(1));
         new(ret.data_->value.data()) T{forward<Args>(args)...};
         return ret;
     }
@@ -154,7 +154,7 @@ struct Arc {
         Arc ret;
         ret.data_ =
             reinterpret_cast<Data*>(reinterpret_cast<u8*>(value) - RPP_OFFSETOF(Data, value));
-        ret.data_->references.incr();
+        ret.data_->references.incr(Thread::Order::relaxed);
         return ret;
     }
 
@@ -164,7 +164,8 @@ struct Arc {
     [[nodiscard]] Arc dup() const noexcept {
         Arc ret;
         ret.data_ = data_;
-        if(data_) data_->references.incr();
+        // Only an existing reference can make a new one, so no ordering is required.
+        if(data_) data_->references.incr(Thread::Order::relaxed);
         return ret;
     }
 
@@ -201,7 +202,7 @@ struct Arc {
     }
 
     [[nodiscard]] u64 references() const noexcept {
-        return data_ ? data_->references.load() : 0;
+        return data_ ? data_->references.load(Thread::Order::relaxed) : 0;
     }
     void clear() {
         drop();
@@ -210,7 +211,8 @@ struct Arc {
 private:
     void drop() noexcept {
         if(!data_) return;
-        if(data_->references.decr() == 0) {
+        // Our writes to the value happen before the last owner destroys it.
+        if(data_->references.decr(Thread::Order::acq_rel) == 0) {
             data_->value.destruct();
             A::template destroy<Data>(data_);
         }
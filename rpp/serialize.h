@@ -0,0 +1,582 @@
+
+#pragma once
+
+#include "base.h"
+#include "variant.h"
+
+// Binary serialization generated from Reflect. Values are written field by field in declaration
+// order, with containers prefixed by their length and Opt, Box and Variant by a tag byte.
+// Trivially copyable types without padding, bools, or pointers are packed: they are aligned to
+// their natural alignment and copied in bulk, including whole arrays and vectors of them.
+//
+// Each top-level value starts with a schema hash built from the kinds, field names, and element
+// schemas of its type, so reading data written for a different layout fails instead of producing
+// garbage. The schema does not include record names, so a record whose String_View and Slice
+// fields mirror another record's String and Vec fields reads the same bytes without copying.
+// Packed values can also be viewed in place. Recursive types are not supported.
+
+namespace rpp::Serialize {
+
+using namespace Reflect;
+
+template<typename T>
+struct Codec;
+
+template<typename T>
+concept Packed = Codec<T>::packed;
+
+template<Allocator A = Mdefault>
+struct Writer {
+
+    Writer() noexcept = default;
+    ~Writer() noexcept = default;
+
+    Writer(const Writer&) noexcept = delete;
+    Writer& operator=(const Writer&) noexcept = delete;
+
+    Writer(Writer&&) noexcept = default;
+    Writer& operator=(Writer&&) noexcept = default;
+
+    template<typename T>
+    void write(const T& value) noexcept {
+        Codec<T>::encode(*this, value);
+    }
+
+    void bytes(const void* data, u64 length) noexcept {
+        if(length == 0) return;
+        Libc::memcpy(reserve(length), data, length);
+        length_ += length;
+    }
+
+    // The buffer is zeroed as it grows, so padding needs no writes.
+    void align(u64 alignment) noexcept {
+        u64 padding = Math::align(length_, alignment) - length_;
+        static_cast<void>(reserve(padding));
+        length_ += padding;
+    }
+
+    [[nodiscard]] u64 length() const noexcept {
+        return length_;
+    }
+
+    [[nodiscard]] Vec<u8, A> finish() noexcept {
+        buffer_.resize(length_);
+        length_ = 0;
+        return move(buffer_);
+    }
+
+private:
+    [[nodiscard]] u8* reserve(u64 length) noexcept {
+        if(length_ + length > buffer_.length()) {
+            u64 capacity = Math::max(buffer_.length() * 2, length_ + length);
+            buffer_.resize(Math::max(capacity, u64{64}));
+        }
+        return buffer_.data() + length_;
+    }
+
+    Vec<u8, A> buffer_;
+    u64 length_ = 0;
+};
+
+struct Reader {
+
+    explicit Reader(Slice<u8> bytes) noexcept : data_(bytes.data()), length_(bytes.length()) {
+    }
+
+    template<typename T>
+    [[nodiscard]] bool read(T& value) noexcept {
+        return Codec<T>::decode(*this, value);
+    }
+
+    [[nodiscard]] bool bytes(void* data, u64 length) noexcept {
+        if(length > remaining()) return false;
+        if(length) Libc::memcpy(data, data_ + offset_, length);
+        offset_ += length;
+        return true;
+    }
+
+    // Returns length bytes in place and skips over them.
+    [[nodiscard]] bool skip(u64 length, const u8*& data) noexcept {
+        if(length > remaining()) return false;
+        data = data_ + offset_;
+        offset_ += length;
+        return true;
+    }
+
+    [[nodiscard]] bool align(u64 alignment) noexcept {
+        u64 offset = Math::align(offset_, alignment);
+        if(offset > length_) return false;
+        offset_ = offset;
+        return true;
+    }
+
+    // Points into the buffer instead of copying. Fails if the buffer is not suitably aligned.
+    template<Packed T>
+    [[nodiscard]] Opt<Ref<const T>> view() noexcept {
+        const u8* data = null;
+        if(!align(alignof(T)) || !skip(sizeof(T), data)) return {};
+        if(reinterpret_cast<u64>(data) % alignof(T)) return {};
+        return Opt{Ref<const T>{*reinterpret_cast<const T*>(data)}};
+    }
+
+    [[nodiscard]] u64 remaining() const noexcept {
+        return length_ - offset_;
+    }
+    [[nodiscard]] bool done() const noexcept {
+        return offset_ == length_;
+    }
+
+private:
+    const u8* data_ = null;
+    u64 length_ = 0;
+    u64 offset_ = 0;
+};
+
+namespace detail {
+
+[[nodiscard]] constexpr u64 schema_name(const Literal& name) noexcept {
+    u64 length = 0;
+    while(name.c_string[length]) length++;
+    return Hash::bytes(name.c_string, length);
+}
+
+[[nodiscard]] constexpr u64 schema_combine(u64 schema, u64 next) noexcept {
+    return Hash::hash_combine(schema, next);
+}
+
+struct Record_Schema {
+    template<typename F>
+    constexpr void apply() noexcept {
+        schema = schema_combine(schema, schema_name(F::name));
+        schema = schema_combine(schema, Codec<Decay<typename F::type>>::schema);
+    }
+    u64 schema = 0;
+};
+
+struct Record_Packed {
+    template<typename F>
+    constexpr void apply() noexcept {
+        packed = packed && Codec<Decay<typename F::type>>::packed;
+        size += sizeof(typename F::type);
+    }
+    bool packed = true;
+    u64 size = 0;
+};
+
+template<typename T>
+[[nodiscard]] consteval u64 schema() noexcept {
+    using R = Refl<T>;
+    u64 schema = static_cast<u64>(R::kind);
+    if constexpr(R::kind == Kind::array_) {
+        schema = schema_combine(schema, R::length);
+        schema = schema_combine(schema, Codec<typename R::underlying>::schema);
+    } else if constexpr(R::kind == Kind::enum_) {
+        schema = schema_combine(schema, sizeof(T));
+        iterate_enum<T>([&](const Literal& name, T value) {
+            schema = schema_combine(schema, schema_name(name));
+            schema = schema_combine(schema, static_cast<u64>(value));
+        });
+    } else if constexpr(R::kind == Kind::record_) {
+        Record_Schema fields{schema};
+        Iter<Record_Schema, typename R::members>::apply(fields);
+        schema = fields.schema;
+    }
+    return schema;
+}
+
+template<typename T>
+[[nodiscard]] consteval bool packed() noexcept {
+    using R = Refl<T>;
+    if constexpr(!Trivially_Copyable<T>) {
+        return false;
+    } else if constexpr(R::kind == Kind::array_) {
+        using U = typename R::underlying;
+        return Codec<U>::packed && sizeof(T) == R::length * sizeof(U);
+    } else if constexpr(R::kind == Kind::record_) {
+        Record_Packed fields;
+        Iter<Record_Packed, typename R::members>::apply(fields);
+        return fields.packed && fields.size == sizeof(T);
+    } else {
+        return R::kind != Kind::bool_;
+    }
+}
+
+// Decoding fills in an existing value, so elements of containers start from a blank one.
+template<typename T>
+[[nodiscard]] T blank() noexcept {
+    if constexpr(Default_Constructable<T>) {
+        return T{};
+    } else {
+        return Codec<T>::blank();
+    }
+}
+
+template<Allocator A>
+struct Encode_Field {
+    template<typename T>
+    void apply(const Literal&, const T& value) noexcept {
+        Codec<Decay<T>>::encode(writer, value);
+    }
+    Writer<A>& writer;
+};
+
+struct Decode_Field {
+    template<typename T>
+    void apply(const Literal&, T& value) noexcept {
+        ok = ok && Codec<Decay<T>>::decode(reader, value);
+    }
+    Reader& reader;
+    bool ok = true;
+};
+
+template<Allocator A>
+void encode_length(Writer<A>& writer, u64 length) noexcept {
+    writer.align(alignof(u64));
+    writer.bytes(&length, sizeof(u64));
+}
+
+[[nodiscard]] inline bool decode_length(Reader& reader, u64& length) noexcept {
+    return reader.align(alignof(u64)) && reader.bytes(&length, sizeof(u64));
+}
+
+template<Allocator A>
+void encode_tag(Writer<A>& writer, u8 tag) noexcept {
+    writer.bytes(&tag, 1);
+}
+
+[[nodiscard]] inline bool decode_tag(Reader& reader, u8& tag, u8 limit) noexcept {
+    return reader.bytes(&tag, 1) && tag < limit;
+}
+
+template<Packed T, Allocator A>
+void encode_packed(Writer<A>& writer, const T* data, u64 length) noexcept {
+    encode_length(writer, length);
+    writer.align(alignof(T));
+    writer.bytes(data, length * sizeof(T));
+}
+
+// Returns the encoded elements in place, or null if the buffer is short or misaligned.
+template<Packed T>
+[[nodiscard]] const T* view_packed(Reader& reader, u64& length) noexcept {
+    const u8* data = null;
+    if(!decode_length(reader, length) || !reader.align(alignof(T))) return null;
+    if(length > reader.remaining() / sizeof(T)) return null;
+    if(!reader.skip(length * sizeof(T), data)) return null;
+    if(reinterpret_cast<u64>(data) % alignof(T)) return null;
+    return reinterpret_cast<const T*>(data);
+}
+
+} // namespace detail
+
+template<typename T>
+struct Codec {
+    using R = Refl<T>;
+    static_assert(R::kind != Kind::void_ && R::kind != Kind::pointer_,
+                  "Pointers can not be serialized.");
+
+    constexpr static bool packed = detail::packed<T>();
+    constexpr static u64 schema = detail::schema<T>();
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const T& value) noexcept {
+        if constexpr(packed) {
+            writer.align(alignof(T));
+            writer.bytes(&value, sizeof(T));
+        } else if constexpr(R::kind == Kind::bool_) {
+            detail::encode_tag(writer, value ? 1 : 0);
+        } else if constexpr(R::kind == Kind::array_) {
+            for(u64 i = 0; i < R::length; i++) {
+                Codec<typename R::underlying>::encode(writer, value[i]);
+            }
+        } else {
+            static_assert(R::kind == Kind::record_);
+            iterate_record(detail::Encode_Field<A>{writer}, value);
+        }
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, T& value) noexcept {
+        if constexpr(packed) {
+            return reader.align(alignof(T)) && reader.bytes(&value, sizeof(T));
+        } else if constexpr(R::kind == Kind::bool_) {
+            u8 tag = 0;
+            if(!detail::decode_tag(reader, tag, 2)) return false;
+            value = tag == 1;
+            return true;
+        } else if constexpr(R::kind == Kind::array_) {
+            for(u64 i = 0; i < R::length; i++) {
+                if(!Codec<typename R::underlying>::decode(reader, value[i])) return false;
+            }
+            return true;
+        } else {
+            static_assert(R::kind == Kind::record_);
+            detail::Decode_Field fields{reader};
+            iterate_record(fields, value);
+            return fields.ok;
+        }
+    }
+};
+
+template<Allocator S>
+struct Codec<String<S>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_name("String");
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const String<S>& value) noexcept {
+        detail::encode_length(writer, value.length());
+        writer.bytes(value.data(), value.length());
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, String<S>& value) noexcept {
+        u64 length = 0;
+        if(!detail::decode_length(reader, length) || length > reader.remaining()) return false;
+        value = String<S>{length};
+        value.set_length(length);
+        return reader.bytes(value.data(), length);
+    }
+};
+
+// Decoding a String_View points into the buffer being read.
+template<>
+struct Codec<String_View> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_name("String");
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, String_View value) noexcept {
+        detail::encode_length(writer, value.length());
+        writer.bytes(value.data(), value.length());
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, String_View& value) noexcept {
+        u64 length = 0;
+        const u8* data = null;
+        if(!detail::decode_length(reader, length) || !reader.skip(length, data)) return false;
+        value = String_View{data, length};
+        return true;
+    }
+};
+
+template<typename T, Allocator V>
+struct Codec<Vec<T, V>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_combine(detail::schema_name("Vec"),
+                                                         Codec<T>::schema);
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Vec<T, V>& value) noexcept {
+        if constexpr(Packed<T>) {
+            detail::encode_packed(writer, value.data(), value.length());
+        } else {
+            detail::encode_length(writer, value.length());
+            for(const T& item : value) Codec<T>::encode(writer, item);
+        }
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Vec<T, V>& value) noexcept {
+        if constexpr(Packed<T>) {
+            u64 length = 0;
+            const u8* data = null;
+            if(!detail::decode_length(reader, length) || !reader.align(alignof(T))) return false;
+            if(length > reader.remaining() / sizeof(T)) return false;
+            if(!reader.skip(length * sizeof(T), data)) return false;
+            value = Vec<T, V>{length};
+            if(length) Libc::memcpy(value.data(), data, length * sizeof(T));
+            value.unsafe_fill();
+            return true;
+        } else {
+            u64 length = 0;
+            if(!detail::decode_length(reader, length)) return false;
+            // Don't trust the length for the reservation: every element takes at least a byte.
+            value = Vec<T, V>{Math::min(length, reader.remaining())};
+            for(u64 i = 0; i < length; i++) {
+                T item = detail::blank<T>();
+                if(!Codec<T>::decode(reader, item)) return false;
+                value.push(move(item));
+            }
+            return true;
+        }
+    }
+};
+
+// Decoding a Slice points into the buffer being read, so it requires packed elements.
+template<typename T>
+struct Codec<Slice<T>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = Codec<Vec<T>>::schema;
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Slice<T>& value) noexcept {
+        if constexpr(Packed<T>) {
+            detail::encode_packed(writer, value.data(), value.length());
+        } else {
+            detail::encode_length(writer, value.length());
+            for(const T& item : value) Codec<T>::encode(writer, item);
+        }
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Slice<T>& value) noexcept
+        requires Packed<T>
+    {
+        u64 length = 0;
+        const T* data = detail::view_packed<T>(reader, length);
+        if(!data) return false;
+        value = Slice<T>{data, length};
+        return true;
+    }
+};
+
+template<typename T>
+struct Codec<Opt<T>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_combine(detail::schema_name("Opt"),
+                                                         Codec<T>::schema);
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Opt<T>& value) noexcept {
+        detail::encode_tag(writer, value ? 1 : 0);
+        if(value) Codec<T>::encode(writer, *value);
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Opt<T>& value) noexcept {
+        u8 tag = 0;
+        if(!detail::decode_tag(reader, tag, 2)) return false;
+        value.clear();
+        if(tag == 0) return true;
+        T item = detail::blank<T>();
+        if(!Codec<T>::decode(reader, item)) return false;
+        value = move(item);
+        return true;
+    }
+};
+
+template<typename T, Scalar_Allocator P>
+struct Codec<Box<T, P>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_combine(detail::schema_name("Box"),
+                                                         Codec<T>::schema);
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Box<T, P>& value) noexcept {
+        detail::encode_tag(writer, value ? 1 : 0);
+        if(value) Codec<T>::encode(writer, *value);
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Box<T, P>& value) noexcept {
+        u8 tag = 0;
+        if(!detail::decode_tag(reader, tag, 2)) return false;
+        value = Box<T, P>{};
+        if(tag == 0) return true;
+        T item = detail::blank<T>();
+        if(!Codec<T>::decode(reader, item)) return false;
+        value = Box<T, P>{move(item)};
+        return true;
+    }
+};
+
+template<typename... Ts>
+struct Codec<Variant<Ts...>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = [] {
+        u64 schema = detail::schema_name("Variant");
+        ((schema = detail::schema_combine(schema, Codec<Ts>::schema)), ...);
+        return schema;
+    }();
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Variant<Ts...>& value) noexcept {
+        detail::encode_tag(writer, value.index());
+        value.match(Overload{[&](const Ts& item) { Codec<Ts>::encode(writer, item); }...});
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Variant<Ts...>& value) noexcept {
+        u8 tag = 0;
+        if(!detail::decode_tag(reader, tag, static_cast<u8>(sizeof...(Ts)))) return false;
+        return decode_n(reader, value, tag, Index_Sequence_For<Ts...>{});
+    }
+
+    [[nodiscard]] static Variant<Ts...> blank() noexcept {
+        return Variant<Ts...>{detail::blank<Choose<0, Ts...>>()};
+    }
+
+private:
+    template<u64 I>
+    [[nodiscard]] static bool decode_one(Reader& reader, Variant<Ts...>& value) noexcept {
+        using T = Choose<I, Ts...>;
+        T item = detail::blank<T>();
+        if(!Codec<T>::decode(reader, item)) return false;
+        value = Variant<Ts...>{move(item)};
+        return true;
+    }
+
+    template<u64... Is>
+    [[nodiscard]] static bool decode_n(Reader& reader, Variant<Ts...>& value, u8 tag,
+                                       Index_Sequence<Is...>) noexcept {
+        using Decode = bool (*)(Reader&, Variant<Ts...>&);
+        constexpr static Decode table[] = {&decode_one<Is>...};
+        return table[tag](reader, value);
+    }
+};
+
+template<typename K, typename V, Allocator M>
+struct Codec<Map<K, V, M>> {
+    constexpr static bool packed = false;
+    constexpr static u64 schema = detail::schema_combine(
+        detail::schema_combine(detail::schema_name("Map"), Codec<K>::schema), Codec<V>::schema);
+
+    template<Allocator A>
+    static void encode(Writer<A>& writer, const Map<K, V, M>& value) noexcept {
+        detail::encode_length(writer, value.length());
+        for(const Pair<K, V>& item : value) {
+            Codec<K>::encode(writer, item.first);
+            Codec<V>::encode(writer, item.second);
+        }
+    }
+
+    [[nodiscard]] static bool decode(Reader& reader, Map<K, V, M>& value) noexcept {
+        u64 length = 0;
+        if(!detail::decode_length(reader, length)) return false;
+        value.clear();
+        for(u64 i = 0; i < length; i++) {
+            K key = detail::blank<K>();
+            V item = detail::blank<V>();
+            if(!Codec<K>::decode(reader, key) || !Codec<V>::decode(reader, item)) return false;
+            if(value.contains(key)) return false;
+            value.insert(move(key), move(item));
+        }
+        return true;
+    }
+};
+
+// Encodes value after the schema hash of its type.
+template<Allocator A = Mdefault, typename T>
+[[nodiscard]] Vec<u8, A> write(const T& value) noexcept {
+    Writer<A> writer;
+    writer.write(Codec<T>::schema);
+    writer.write(value);
+    return writer.finish();
+}
+
+// Decodes a value written by write. Fails if the schema does not match or bytes are left over.
+template<typename T>
+[[nodiscard]] Opt<T> read(Slice<u8> bytes) noexcept {
+    Reader reader{bytes};
+    u64 schema = 0;
+    if(!reader.read(schema) || schema != Codec<T>::schema) return {};
+    T value = detail::blank<T>();
+    if(!reader.read(value) || !reader.done()) return {};
+    return Opt<T>{move(value)};
+}
+
+// Views a packed value written by write without copying it.
+template<Packed T>
+[[nodiscard]] Opt<Ref<const T>> view(Slice<u8> bytes) noexcept {
+    Reader reader{bytes};
+    u64 schema = 0;
+    if(!reader.read(schema) || schema != Codec<T>::schema) return {};
+    Opt<Ref<const T>> value = reader.view<T>();
+    if(!reader.done()) return {};
+    return value;
+}
+
+} // namespace rpp::Serialize
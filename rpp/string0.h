@@ -10,6 +10,9 @@ namespace rpp {
 template<Allocator A = Mdefault>
 struct String;
 
+template<typename T>
+struct Opt;
+
 struct String_View {
 
     constexpr String_View() noexcept = default;
@@ -70,6 +73,19 @@ struct String_View {
 
     [[nodiscard]] constexpr String_View sub(u64 start, u64 end) const noexcept;
 
+    struct Split;
+
+    // Scan 32 bytes at a time.
+    [[nodiscard]] Opt<u64> find(u8 c) const noexcept;
+    [[nodiscard]] Opt<u64> find(String_View needle) const noexcept;
+    [[nodiscard]] Opt<u64> find_any(String_View set) const noexcept;
+    [[nodiscard]] u64 count(u8 c) const noexcept;
+
+    // Yields the pieces between delimiters, including empty ones.
+    [[nodiscard]] Split split(u8 delimiter) const noexcept;
+    // Yields each line without its terminator. A trailing newline does not start an empty line.
+    [[nodiscard]] Split lines() const noexcept;
+
     [[nodiscard]] constexpr String_View clone() const noexcept {
         return String_View{data_, length_};
     }
@@ -85,12 +101,17 @@ template<Allocator A>
 struct String {
 
     String() noexcept = default;
-    explicit String(u64 capacity) noexcept
-        : data_(reinterpret_cast<u8*>(A::alloc(capacity))), length_(0), capacity_(capacity) {
+    explicit String(u64 capacity) noexcept {
+        if(capacity <= INLINE_CAPACITY) {
+            length_ = INLINE;
+        } else {
+            data_ = reinterpret_cast<u8*>(A::alloc(capacity));
+            capacity_ = capacity;
+        }
     }
 
     ~String() noexcept {
-        A::free(data_);
+        if(!is_inline()) A::free(data_);
         data_ = null;
         capacity_ = 0;
         length_ = 0;
@@ -99,30 +120,27 @@ struct String {
     String(const String& src) noexcept = delete;
     String& operator=(const String& src) noexcept = delete;
 
-    String(String&& src) noexcept
-        : data_(src.data_), length_(src.length_), capacity_(src.capacity_) {
+    String(String&& src) noexcept : length_(src.length_) {
+        Libc::memcpy(inline_, src.inline_, INLINE_CAPACITY);
         src.data_ = null;
-        src.length_ = 0;
         src.capacity_ = 0;
+        src.length_ = 0;
     }
     String& operator=(String&& src) noexcept {
         this->~String();
-        data_ = src.data_;
         length_ = src.length_;
-        capacity_ = src.capacity_;
+        Libc::memcpy(inline_, src.inline_, INLINE_CAPACITY);
         src.data_ = null;
-        src.length_ = 0;
         src.capacity_ = 0;
+        src.length_ = 0;
         return *this;
     }
 
     template<Allocator B = A>
     [[nodiscard]] String<B> clone() const noexcept {
-        String<B> ret;
-        ret.data_ = reinterpret_cast<u8*>(B::alloc(capacity_));
-        ret.length_ = length_;
-        ret.capacity_ = capacity_;
-        Libc::memcpy(ret.data_, data_, length_);
+        String<B> ret{capacity()};
+        ret.set_length(length());
+        Libc::memcpy(ret.data(), data(), length());
         return ret;
     }
 
@@ -132,7 +150,7 @@ struct String {
     [[nodiscard]] const u8& operator[](u64 idx) const noexcept;
 
     [[nodiscard]] String_View view() const noexcept {
-        return String_View{data_, length_};
+        return String_View{data(), length()};
     }
     [[nodiscard]] String_View sub(u64 start, u64 end) const noexcept;
 
@@ -142,33 +160,36 @@ struct String {
     [[nodiscard]] u64 write(u64 i, String_View text) noexcept;
 
     [[nodiscard]] u8* begin() noexcept {
-        return data_;
+        return data();
     }
     [[nodiscard]] u8* end() noexcept {
-        return data_ + length_;
+        return data() + length();
     }
     [[nodiscard]] const u8* begin() const noexcept {
-        return data_;
+        return data();
     }
     [[nodiscard]] const u8* end() const noexcept {
-        return data_ + length_;
+        return data() + length();
     }
 
     [[nodiscard]] u8* data() noexcept {
-        return data_;
+        return is_inline() ? inline_ : data_;
     }
     [[nodiscard]] const u8* data() const noexcept {
-        return data_;
+        return is_inline() ? inline_ : data_;
     }
     [[nodiscard]] u64 length() const noexcept {
-        return length_;
+        return length_ & ~INLINE;
     }
     [[nodiscard]] u64 capacity() const noexcept {
-        return capacity_;
+        return is_inline() ? INLINE_CAPACITY : capacity_;
     }
 
     [[nodiscard]] bool empty() const noexcept {
-        return length_ == 0;
+        return length() == 0;
+    }
+    [[nodiscard]] bool is_inline() const noexcept {
+        return length_ & INLINE;
     }
 
     template<Allocator RA>
@@ -177,22 +198,32 @@ struct String {
     template<Allocator RA, Allocator B>
     [[nodiscard]] String<RA> append(const String<B>& next) const noexcept;
 
+    void to_uppercase() noexcept;
+    void to_lowercase() noexcept;
+
 private:
-    u8* data_ = null;
+    // Strings that fit in the space of the heap pointer and capacity are stored in place. Moving
+    // one copies its contents, so views into it are invalidated.
+    constexpr static u64 INLINE_CAPACITY = 16;
+    constexpr static u64 INLINE = u64{1} << 63;
+
     u64 length_ = 0;
-    u64 capacity_ = 0;
+    union {
+        struct {
+            u8* data_ = null;
+            u64 capacity_ = 0;
+        };
+        u8 inline_[INLINE_CAPACITY];
+    };
 
     friend struct String_View;
-    friend struct Reflect::Refl<String>;
 };
 
 template<Allocator A>
 [[nodiscard]] String<A> String_View::string() const noexcept {
-    String<A> ret;
-    ret.data_ = reinterpret_cast<u8*>(A::alloc(length_));
-    ret.length_ = length_;
-    ret.capacity_ = length_;
-    Libc::memcpy(ret.data_, data_, length_);
+    String<A> ret{length_};
+    ret.set_length(length_);
+    Libc::memcpy(ret.data(), data_, length_);
     return ret;
 }
 
@@ -256,6 +287,9 @@ namespace ascii {
     return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v';
 }
 
+void to_uppercase(u8* data, u64 length) noexcept;
+void to_lowercase(u8* data, u64 length) noexcept;
+
 } // namespace ascii
 
 namespace detail {
@@ -277,26 +311,25 @@ concept Any_String = detail::Is_String<T>::value;
 
 RPP_RECORD(String_View, RPP_FIELD(data_), RPP_FIELD(length_));
 
+// No fields: data_ and capacity_ share storage with the inline bytes, and length_ carries the
+// INLINE flag, so generic field access would read garbage. Format, Hash and Serialize handle
+// String directly.
 template<Allocator A>
-RPP_TEMPLATE_RECORD(String, A, RPP_FIELD(data_), RPP_FIELD(length_), RPP_FIELD(capacity_));
+RPP_TEMPLATE_RECORD(String, A);
 
 namespace Hash {
 
 template<Allocator A>
 struct Hash<String<A>> {
     [[nodiscard]] static u64 hash(const String<A>& string) noexcept {
-        u64 h = 0;
-        for(u8 c : string) h = hash_combine(h, rpp::hash(c));
-        return h;
+        return bytes(string.data(), string.length());
     }
 };
 
 template<>
 struct Hash<String_View> {
     [[nodiscard]] constexpr static u64 hash(const String_View& string) noexcept {
-        u64 h = 0;
-        for(u8 c : string) h = hash_combine(h, rpp::hash(c));
-        return h;
+        return bytes(string.data(), string.length());
     }
 };
 
@@ -9,27 +9,27 @@ namespace rpp {
 
 template<Allocator A>
 void String<A>::set_length(u64 length) noexcept {
-    assert(length <= capacity_);
-    length_ = length;
+    assert(length <= capacity());
+    length_ = length | (length_ & INLINE);
 }
 
 template<Allocator A>
 [[nodiscard]] const u8& String<A>::operator[](u64 idx) const noexcept {
-    assert(idx < length_);
-    return data_[idx];
+    assert(idx < length());
+    return data()[idx];
 }
 
 template<Allocator A>
 [[nodiscard]] u8& String<A>::operator[](u64 idx) noexcept {
-    assert(idx < length_);
-    return data_[idx];
+    assert(idx < length());
+    return data()[idx];
 }
 
 template<Allocator A>
 [[nodiscard]] String_View String<A>::sub(u64 start, u64 end) const noexcept {
     assert(start <= end);
-    assert(end <= length_);
-    return String_View{data_ + start, end - start};
+    assert(end <= length());
+    return String_View{data() + start, end - start};
 }
 
 template<Allocator A>
@@ -44,10 +44,10 @@ template<Allocator A>
 template<Allocator SA>
 template<Allocator RA>
 [[nodiscard]] String<RA> String<SA>::terminate() const noexcept {
-    String<RA> ret{length_ + 1};
-    ret.set_length(length_ + 1);
-    Libc::memcpy(ret.data(), data_, length_);
-    ret[length_] = '\0';
+    String<RA> ret{length() + 1};
+    ret.set_length(length() + 1);
+    Libc::memcpy(ret.data(), data(), length());
+    ret[length()] = '\0';
     return ret;
 }
 
@@ -57,6 +57,77 @@ template<Allocator RA>
     return String_View{data_ + start, end - start};
 }
 
+struct String_View::Split {
+
+    struct Iterator {
+        Iterator& operator++() noexcept {
+            advance();
+            return *this;
+        }
+
+        [[nodiscard]] String_View operator*() const noexcept {
+            return token_;
+        }
+
+        [[nodiscard]] bool operator==(const Iterator& rhs) const noexcept {
+            return done_ == rhs.done_ && (done_ || token_.data() == rhs.token_.data());
+        }
+
+    private:
+        Iterator() noexcept = default;
+        explicit Iterator(const Split& split) noexcept
+            : rest_(split.input), delimiter_(split.delimiter), lines_(split.lines), done_(false) {
+            advance();
+        }
+
+        void advance() noexcept {
+            if(last_ || (lines_ && rest_.empty())) {
+                done_ = true;
+                return;
+            }
+            if(Opt<u64> at = rest_.find(delimiter_)) {
+                token_ = rest_.sub(0, *at);
+                rest_ = rest_.sub(*at + 1, rest_.length());
+            } else {
+                token_ = rest_;
+                rest_ = String_View{};
+                last_ = true;
+            }
+            if(lines_ && !token_.empty() && token_[token_.length() - 1] == '\r') {
+                token_ = token_.sub(0, token_.length() - 1);
+            }
+        }
+
+        String_View token_;
+        String_View rest_;
+        u8 delimiter_ = 0;
+        bool lines_ = false;
+        bool last_ = false;
+        bool done_ = true;
+
+        friend struct Split;
+    };
+
+    [[nodiscard]] Iterator begin() const noexcept {
+        return Iterator{*this};
+    }
+    [[nodiscard]] Iterator end() const noexcept {
+        return Iterator{};
+    }
+
+    String_View input;
+    u8 delimiter = 0;
+    bool lines = false;
+};
+
+[[nodiscard]] inline String_View::Split String_View::split(u8 delimiter) const noexcept {
+    return Split{*this, delimiter, false};
+}
+
+[[nodiscard]] inline String_View::Split String_View::lines() const noexcept {
+    return Split{*this, '\n', true};
+}
+
 [[nodiscard]] constexpr const u8& String_View::operator[](u64 idx) const noexcept {
     assert(idx < length_);
     return data_[idx];
@@ -112,23 +183,23 @@ template<Allocator RA>
 
 template<Allocator A>
 [[nodiscard]] u64 String<A>::write(u64 i, char c) noexcept {
-    assert(i < length_);
-    data_[i] = c;
+    assert(i < length());
+    data()[i] = c;
     return i + 1;
 }
 
 template<Allocator A>
 template<Allocator B>
 [[nodiscard]] u64 String<A>::write(u64 i, const String<B>& text) noexcept {
-    assert(i + text.length() <= length_);
-    Libc::memcpy(data_ + i, text.data(), text.length());
+    assert(i + text.length() <= length());
+    Libc::memcpy(data() + i, text.data(), text.length());
     return i + text.length();
 }
 
 template<Allocator A>
 [[nodiscard]] u64 String<A>::write(u64 i, String_View text) noexcept {
-    assert(i + text.length() <= length_);
-    Libc::memcpy(data_ + i, text.data(), text.length());
+    assert(i + text.length() <= length());
+    Libc::memcpy(data() + i, text.data(), text.length());
     return i + text.length();
 }
 
@@ -144,13 +215,23 @@ template<Allocator A>
 template<Allocator A>
 template<Allocator RA, Allocator B>
 [[nodiscard]] String<RA> String<A>::append(const String<B>& next) const noexcept {
-    String<RA> ret{length_ + next.length()};
-    ret.set_length(length_ + next.length());
-    Libc::memcpy(ret.data(), data_, length_);
-    Libc::memcpy(ret.data() + length_, next.data(), next.length());
+    String<RA> ret{length() + next.length()};
+    ret.set_length(length() + next.length());
+    Libc::memcpy(ret.data(), data(), length());
+    Libc::memcpy(ret.data() + length(), next.data(), next.length());
     return ret;
 }
 
+template<Allocator A>
+void String<A>::to_uppercase() noexcept {
+    ascii::to_uppercase(data(), length());
+}
+
+template<Allocator A>
+void String<A>::to_lowercase() noexcept {
+    ascii::to_lowercase(data(), length());
+}
+
 namespace Format {
 
 template<>
@@ -179,6 +260,21 @@ struct Write<O, String<A>> {
     }
 };
 
+template<>
+struct Append<String_View> {
+    template<Allocator O>
+    static void append(String_Builder<O>& output, String_View value) noexcept {
+        output.append(value);
+    }
+};
+template<Allocator A>
+struct Append<String<A>> {
+    template<Allocator O>
+    static void append(String_Builder<O>& output, const String<A>& value) noexcept {
+        output.append(value.view());
+    }
+};
+
 } // namespace Format
 
 } // namespace rpp
\ No newline at end of file
@@ -0,0 +1,358 @@
+
+#pragma once
+
+#include "async.h"
+#include "base.h"
+#include "pool.h"
+
+namespace rpp::Async {
+
+namespace detail {
+
+template<Allocator A>
+struct Waiter {
+    std::coroutine_handle<> handle;
+    Pool<A>* pool = null;
+    Priority priority = Priority::normal;
+    Waiter* next = null;
+
+    void resume() noexcept {
+        pool->enqueue(Handle<>{handle}, priority);
+    }
+};
+
+// Intrusive FIFO of suspended coroutines. Nodes live in the awaiters, so waiting never
+// allocates. Not thread safe: the owning primitive guards it with its own mutex.
+template<Allocator A>
+struct Waiter_List {
+
+    [[nodiscard]] bool empty() const noexcept {
+        return head == null;
+    }
+
+    void push(Waiter<A>& waiter) noexcept {
+        waiter.next = null;
+        if(tail) {
+            tail->next = &waiter;
+        } else {
+            head = &waiter;
+        }
+        tail = &waiter;
+    }
+
+    [[nodiscard]] Waiter<A>* pop() noexcept {
+        Waiter<A>* waiter = head;
+        if(waiter) {
+            head = waiter->next;
+            if(!head) tail = null;
+        }
+        return waiter;
+    }
+
+    [[nodiscard]] Waiter<A>* take() noexcept {
+        Waiter<A>* waiters = head;
+        head = null;
+        tail = null;
+        return waiters;
+    }
+
+    // Must be called without holding the owner's mutex. Copies each node out before enqueueing
+    // it, as the resumed coroutine may immediately destroy it. Consecutive waiters on the same
+    // pool and priority are enqueued as one batch.
+    static void resume_all(Waiter<A>* waiter) noexcept {
+        constexpr u64 batch = 64;
+        Array<Handle<>, batch> handles;
+        u64 n = 0;
+        Pool<A>* pool = null;
+        Priority priority = Priority::normal;
+        while(waiter) {
+            Waiter<A>* next = waiter->next;
+            if(n == batch || (n > 0 && (waiter->pool != pool || waiter->priority != priority))) {
+                pool->enqueue_batch(Slice<Handle<>>{handles.data(), n}, priority);
+                n = 0;
+            }
+            pool = waiter->pool;
+            priority = waiter->priority;
+            handles[n++] = Handle<>{waiter->handle};
+            waiter = next;
+        }
+        if(n > 0) pool->enqueue_batch(Slice<Handle<>>{handles.data(), n}, priority);
+    }
+
+private:
+    Waiter<A>* head = null;
+    Waiter<A>* tail = null;
+};
+
+} // namespace detail
+
+// Permits go to waiters in arrival order: release hands a permit directly to the oldest waiter,
+// and acquire only takes a free permit when nobody is queued.
+template<Allocator A = Alloc>
+struct Semaphore {
+
+    struct Acquire {
+        explicit Acquire(Semaphore& semaphore, Pool<A>& pool, Priority priority) noexcept
+            : semaphore{semaphore}, waiter{{}, &pool, priority, null} {
+        }
+
+        [[nodiscard]] bool await_ready() noexcept {
+            return semaphore.try_acquire();
+        }
+        [[nodiscard]] bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            waiter.handle = handle;
+            Thread::Lock lock(semaphore.mutex);
+            // Counting ourselves as a waiter and joining the queue both happen under the lock,
+            // so a release that sees the count will find us queued.
+            u64 state = semaphore.state.load();
+            for(;;) {
+                u64 next = available(state) > 0 ? state - 1 : state + WAITER;
+                u64 prev = semaphore.state.compare_and_swap(state, next);
+                if(prev == state) break;
+                state = prev;
+            }
+            // Free permits imply an empty queue, so taking one here doesn't jump ahead.
+            if(available(state) > 0) return false;
+            semaphore.waiters.push(waiter);
+            return true;
+        }
+        void await_resume() noexcept {
+        }
+
+    private:
+        Semaphore& semaphore;
+        detail::Waiter<A> waiter;
+    };
+
+    explicit Semaphore(i64 permits = 0) noexcept : state{static_cast<u64>(permits)} {
+        assert(permits >= 0 && static_cast<u64>(permits) < WAITER);
+    }
+    ~Semaphore() noexcept {
+        assert(waiters.empty());
+    }
+
+    Semaphore(const Semaphore&) noexcept = delete;
+    Semaphore& operator=(const Semaphore&) noexcept = delete;
+
+    Semaphore(Semaphore&&) noexcept = delete;
+    Semaphore& operator=(Semaphore&&) noexcept = delete;
+
+    [[nodiscard]] Acquire acquire(Pool<A>& pool, Priority priority = Priority::normal) noexcept {
+        return Acquire{*this, pool, priority};
+    }
+
+    [[nodiscard]] bool try_acquire() noexcept {
+        u64 value = state.load();
+        while(available(value) > 0 && waiting(value) == 0) {
+            u64 prev = state.compare_and_swap(value, value - 1);
+            if(prev == value) return true;
+            value = prev;
+        }
+        return false;
+    }
+
+    void release() noexcept {
+        u64 value = state.load();
+        while(waiting(value) == 0) {
+            u64 prev = state.compare_and_swap(value, value + 1);
+            if(prev == value) return;
+            value = prev;
+        }
+
+        // Hand the permit directly to the oldest waiter. Another release may have taken it
+        // since we looked, so check again under the lock.
+        detail::Waiter<A>* waiter = null;
+        {
+            Thread::Lock lock(mutex);
+            value = state.load();
+            for(;;) {
+                u64 next = waiting(value) > 0 ? value - WAITER : value + 1;
+                u64 prev = state.compare_and_swap(value, next);
+                if(prev == value) break;
+                value = prev;
+            }
+            if(waiting(value) == 0) return;
+            waiter = waiters.pop();
+        }
+        assert(waiter);
+        waiter->resume();
+    }
+
+private:
+    // The low half of state counts free permits and the high half counts queued waiters. There
+    // are never free permits while anyone is queued.
+    constexpr static u64 WAITER = u64{1} << 32;
+
+    [[nodiscard]] static u64 available(u64 state) noexcept {
+        return state & (WAITER - 1);
+    }
+    [[nodiscard]] static u64 waiting(u64 state) noexcept {
+        return state >> 32;
+    }
+
+    Thread::Atomic<u64> state;
+    Thread::Mutex mutex;
+    detail::Waiter_List<A> waiters;
+};
+
+template<Allocator A = Alloc>
+struct Mutex {
+
+    using Acquire = typename Semaphore<A>::Acquire;
+
+    Mutex() noexcept = default;
+    ~Mutex() noexcept = default;
+
+    Mutex(const Mutex&) noexcept = delete;
+    Mutex& operator=(const Mutex&) noexcept = delete;
+
+    Mutex(Mutex&&) noexcept = delete;
+    Mutex& operator=(Mutex&&) noexcept = delete;
+
+    [[nodiscard]] Acquire lock(Pool<A>& pool, Priority priority = Priority::normal) noexcept {
+        return semaphore.acquire(pool, priority);
+    }
+    [[nodiscard]] bool try_lock() noexcept {
+        return semaphore.try_acquire();
+    }
+    void unlock() noexcept {
+        semaphore.release();
+    }
+
+private:
+    Semaphore<A> semaphore{1};
+};
+
+template<Allocator A = Alloc>
+struct Latch {
+
+    struct Wait {
+        explicit Wait(Latch& latch, Pool<A>& pool, Priority priority) noexcept
+            : latch{latch}, waiter{{}, &pool, priority, null} {
+        }
+
+        [[nodiscard]] bool await_ready() noexcept {
+            return latch.count.load() == 0;
+        }
+        [[nodiscard]] bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            waiter.handle = handle;
+            Thread::Lock lock(latch.mutex);
+            if(latch.count.load() == 0) return false;
+            latch.waiters.push(waiter);
+            return true;
+        }
+        void await_resume() noexcept {
+        }
+
+    private:
+        Latch& latch;
+        detail::Waiter<A> waiter;
+    };
+
+    explicit Latch(i64 count) noexcept : count{count} {
+        assert(count >= 0);
+    }
+    ~Latch() noexcept {
+        assert(waiters.empty());
+    }
+
+    Latch(const Latch&) noexcept = delete;
+    Latch& operator=(const Latch&) noexcept = delete;
+
+    Latch(Latch&&) noexcept = delete;
+    Latch& operator=(Latch&&) noexcept = delete;
+
+    [[nodiscard]] Wait wait(Pool<A>& pool, Priority priority = Priority::normal) noexcept {
+        return Wait{*this, pool, priority};
+    }
+    [[nodiscard]] bool try_wait() noexcept {
+        return count.load() == 0;
+    }
+
+    void count_down() noexcept {
+        i64 value = count.decr();
+        assert(value >= 0);
+        if(value > 0) return;
+
+        detail::Waiter<A>* ready = null;
+        {
+            Thread::Lock lock(mutex);
+            ready = waiters.take();
+        }
+        detail::Waiter_List<A>::resume_all(ready);
+    }
+
+private:
+    Thread::Atomic<i64> count;
+    Thread::Mutex mutex;
+    detail::Waiter_List<A> waiters;
+};
+
+template<Allocator A = Alloc>
+struct Barrier {
+
+    struct Arrive {
+        explicit Arrive(Barrier& barrier, Pool<A>& pool, Priority priority) noexcept
+            : barrier{barrier}, waiter{{}, &pool, priority, null} {
+        }
+
+        [[nodiscard]] bool await_ready() noexcept {
+            return false;
+        }
+        [[nodiscard]] bool await_suspend(std::coroutine_handle<> handle) noexcept {
+            waiter.handle = handle;
+            detail::Waiter<A>* ready = null;
+            {
+                Thread::Lock lock(barrier.mutex);
+                if(++barrier.arrived < barrier.participants) {
+                    barrier.waiters.push(waiter);
+                    return true;
+                }
+                barrier.arrived = 0;
+                barrier.phase_++;
+                ready = barrier.waiters.take();
+            }
+            // The last arrival releases everyone else and continues without suspending.
+            detail::Waiter_List<A>::resume_all(ready);
+            return false;
+        }
+        void await_resume() noexcept {
+        }
+
+    private:
+        Barrier& barrier;
+        detail::Waiter<A> waiter;
+    };
+
+    explicit Barrier(u64 participants) noexcept : participants{participants} {
+        assert(participants > 0);
+    }
+    ~Barrier() noexcept {
+        assert(waiters.empty());
+    }
+
+    Barrier(const Barrier&) noexcept = delete;
+    Barrier& operator=(const Barrier&) noexcept = delete;
+
+    Barrier(Barrier&&) noexcept = delete;
+    Barrier& operator=(Barrier&&) noexcept = delete;
+
+    [[nodiscard]] Arrive arrive_and_wait(Pool<A>& pool,
+                                         Priority priority = Priority::normal) noexcept {
+        return Arrive{*this, pool, priority};
+    }
+
+    [[nodiscard]] u64 phase() noexcept {
+        Thread::Lock lock(mutex);
+        return phase_;
+    }
+
+private:
+    Thread::Mutex mutex;
+    detail::Waiter_List<A> waiters;
+    u64 participants = 0;
+    u64 arrived = 0;
+    u64 phase_ = 0;
+};
+
+} // namespace rpp::Async
@@ -19,6 +19,15 @@ constexpr OS_Thread OS_Thread_Null = 0;
 constexpr OS_Thread_Ret OS_Thread_Ret_Null = null;
 #endif
 
+struct Cpu {
+    u64 id = 0;      // Logical processor, as passed to set_affinity
+    u64 core = 0;    // Physical core within the package, shared by SMT siblings
+    u64 package = 0; // Socket
+    u64 node = 0;    // NUMA node
+};
+
+[[nodiscard]] Vec<Cpu, Alloc> topology() noexcept;
+
 [[nodiscard]] Id sys_id(OS_Thread thread) noexcept;
 void sys_join(OS_Thread thread) noexcept;
 void sys_detach(OS_Thread thread) noexcept;
@@ -168,6 +177,65 @@ template<Allocator A = Alloc, typename F, typename... Args>
     return future;
 }
 
+// Sequence lock for small trivially copyable values. Readers never block writers or each other:
+// they copy the value and retry if a write overlapped the copy. Writers are serialized.
+template<Trivially_Copyable T>
+struct Seqlock {
+
+    Seqlock() noexcept
+        requires Default_Constructable<T>
+    = default;
+    explicit Seqlock(const T& value) noexcept : value_{value} {
+    }
+    ~Seqlock() noexcept = default;
+
+    Seqlock(const Seqlock&) noexcept = delete;
+    Seqlock(Seqlock&&) noexcept = delete;
+
+    Seqlock& operator=(const Seqlock&) noexcept = delete;
+    Seqlock& operator=(Seqlock&&) noexcept = delete;
+
+    [[nodiscard]] T read() const noexcept {
+        alignas(T) u8 bytes[sizeof(T)];
+        for(;;) {
+            u64 before = sequence.load(Order::acquire);
+            if(before & 1) {
+                pause();
+                continue;
+            }
+            Libc::memcpy(bytes, &value_, sizeof(T));
+            fence(Order::acquire);
+            if(sequence.load(Order::relaxed) == before) {
+                return __builtin_bit_cast(T, bytes);
+            }
+        }
+    }
+
+    void write(const T& value) noexcept {
+        u64 current = sequence.load(Order::relaxed);
+        for(;;) {
+            if(current & 1) {
+                pause();
+                current = sequence.load(Order::relaxed);
+                continue;
+            }
+            u64 prev = sequence.compare_and_swap(current, current + 1, Order::acquire);
+            if(prev == current) break;
+            current = prev;
+        }
+        // An odd sequence must be visible before any byte of the new value.
+        fence(Order::release);
+        Libc::memcpy(&value_, &value, sizeof(T));
+        sequence.store(current + 2, Order::release);
+    }
+
+private:
+    Atomic<u64> sequence;
+    T value_;
+
+    friend struct Reflect::Refl<Seqlock>;
+};
+
 } // namespace Thread
 
 template<typename T>
@@ -179,4 +247,11 @@ RPP_NAMED_TEMPLATE_RECORD(::rpp::Thread::Promise, "Promise", void, RPP_FIELD(fla
 template<Allocator A>
 RPP_NAMED_TEMPLATE_RECORD(::rpp::Thread::Thread, "Thread", A, RPP_FIELD(thread));
 
+template<Trivially_Copyable T>
+RPP_NAMED_TEMPLATE_RECORD(::rpp::Thread::Seqlock, "Seqlock", T, RPP_FIELD(sequence),
+                          RPP_FIELD(value_));
+
+RPP_NAMED_RECORD(Thread::Cpu, "Cpu", RPP_FIELD(id), RPP_FIELD(core), RPP_FIELD(package),
+                 RPP_FIELD(node));
+
 } // namespace rpp
@@ -25,6 +25,7 @@ void pause() noexcept;
 [[nodiscard]] u64 perf_frequency() noexcept;
 [[nodiscard]] u64 hardware_threads() noexcept;
 
+// One-shot event. Signalling only makes a syscall if a thread is blocked on the flag.
 struct Flag {
     Flag() noexcept = default;
     ~Flag() noexcept = default;
@@ -47,10 +48,264 @@ private:
 #endif
 };
 
+enum class Order : u8 { relaxed, acquire, release, acq_rel, seq_cst };
+
+namespace detail {
+
+#ifdef RPP_COMPILER_MSVC
+// Locked instructions are full barriers on x64, so the MSVC path ignores the requested order
+// for read-modify-write operations.
+template<typename T>
+[[nodiscard]] T compare_exchange(volatile T* address, T expected, T desired) noexcept {
+    if constexpr(sizeof(T) == 1) {
+        return __builtin_bit_cast(T, _InterlockedCompareExchange8(
+                                         reinterpret_cast<volatile char*>(address),
+                                         __builtin_bit_cast(char, desired),
+                                         __builtin_bit_cast(char, expected)));
+    } else if constexpr(sizeof(T) == 2) {
+        return __builtin_bit_cast(T, _InterlockedCompareExchange16(
+                                         reinterpret_cast<volatile short*>(address),
+                                         __builtin_bit_cast(short, desired),
+                                         __builtin_bit_cast(short, expected)));
+    } else if constexpr(sizeof(T) == 4) {
+        return __builtin_bit_cast(T, _InterlockedCompareExchange(
+                                         reinterpret_cast<volatile long*>(address),
+                                         __builtin_bit_cast(long, desired),
+                                         __builtin_bit_cast(long, expected)));
+    } else {
+        static_assert(sizeof(T) == 8);
+        return __builtin_bit_cast(T, _InterlockedCompareExchange64(
+                                         reinterpret_cast<volatile __int64*>(address),
+                                         __builtin_bit_cast(__int64, desired),
+                                         __builtin_bit_cast(__int64, expected)));
+    }
+}
+#else
+[[nodiscard]] constexpr i32 order(Order order) noexcept {
+    switch(order) {
+    case Order::relaxed: return __ATOMIC_RELAXED;
+    case Order::acquire: return __ATOMIC_ACQUIRE;
+    case Order::release: return __ATOMIC_RELEASE;
+    case Order::acq_rel: return __ATOMIC_ACQ_REL;
+    default: return __ATOMIC_SEQ_CST;
+    }
+}
+
+// A failed compare and swap only loads, so it can't have release semantics.
+[[nodiscard]] constexpr i32 failure_order(Order order) noexcept {
+    switch(order) {
+    case Order::release: return __ATOMIC_RELAXED;
+    case Order::acq_rel: return __ATOMIC_ACQUIRE;
+    default: return detail::order(order);
+    }
+}
+#endif
+
+// Futex on Linux, WaitOnAddress on Windows. Both operate on a 4 byte word.
+void atomic_wait(const void* address, u32 expected) noexcept;
+void atomic_notify_one(const void* address) noexcept;
+void atomic_notify_all(const void* address) noexcept;
+
+} // namespace detail
+
+template<typename T>
+concept Atomic_Value = Int<T> || Pointer<T> || Same<T, bool>;
+
+// Operations default to sequential consistency. Weaker orders follow the C++ memory model.
+template<Atomic_Value T = i64>
+struct Atomic {
+
+    Atomic() noexcept = default;
+    ~Atomic() noexcept = default;
+
+    explicit Atomic(T value) noexcept : value_(value) {
+    }
+
+    // Copies are not atomic.
+    Atomic(const Atomic&) noexcept = default;
+    Atomic(Atomic&&) noexcept = default;
+    Atomic& operator=(const Atomic&) noexcept = default;
+    Atomic& operator=(Atomic&&) noexcept = default;
+
+    [[nodiscard]] T load(Order order = Order::seq_cst) const noexcept {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        T value = *static_cast<const volatile T*>(&value_);
+        _ReadWriteBarrier();
+        return value;
+#else
+        return __atomic_load_n(&value_, detail::order(order));
+#endif
+    }
+
+    void store(T value, Order order = Order::seq_cst) noexcept {
+#ifdef RPP_COMPILER_MSVC
+        if(order == Order::seq_cst) {
+            (void)exchange(value);
+            return;
+        }
+        _ReadWriteBarrier();
+        *static_cast<volatile T*>(&value_) = value;
+#else
+        __atomic_store_n(&value_, value, detail::order(order));
+#endif
+    }
+
+    T exchange(T value, Order order = Order::seq_cst) noexcept {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T) { return value; });
+#else
+        return __atomic_exchange_n(&value_, value, detail::order(order));
+#endif
+    }
+
+    // Returns the previous value; the swap happened if it equals compare_with.
+    [[nodiscard]] T compare_and_swap(T compare_with, T set_to,
+                                     Order order = Order::seq_cst) noexcept {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return detail::compare_exchange(&value_, compare_with, set_to);
+#else
+        __atomic_compare_exchange_n(&value_, &compare_with, set_to, false, detail::order(order),
+                                    detail::failure_order(order));
+        return compare_with;
+#endif
+    }
+
+    // The fetch operations return the previous value.
+    T fetch_add(T value, Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T prev) { return static_cast<T>(prev + value); });
+#else
+        return __atomic_fetch_add(&value_, value, detail::order(order));
+#endif
+    }
+
+    T fetch_sub(T value, Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T prev) { return static_cast<T>(prev - value); });
+#else
+        return __atomic_fetch_sub(&value_, value, detail::order(order));
+#endif
+    }
+
+    T fetch_and(T value, Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T prev) { return static_cast<T>(prev & value); });
+#else
+        return __atomic_fetch_and(&value_, value, detail::order(order));
+#endif
+    }
+
+    T fetch_or(T value, Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T prev) { return static_cast<T>(prev | value); });
+#else
+        return __atomic_fetch_or(&value_, value, detail::order(order));
+#endif
+    }
+
+    T fetch_xor(T value, Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+#ifdef RPP_COMPILER_MSVC
+        (void)order;
+        return update([value](T prev) { return static_cast<T>(prev ^ value); });
+#else
+        return __atomic_fetch_xor(&value_, value, detail::order(order));
+#endif
+    }
+
+    // Unlike the fetch operations, these return the new value.
+    T incr(Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+        return static_cast<T>(fetch_add(1, order) + 1);
+    }
+
+    T decr(Order order = Order::seq_cst) noexcept
+        requires Int<T>
+    {
+        return static_cast<T>(fetch_sub(1, order) - 1);
+    }
+
+    // Blocks until the value no longer equals expected. May return spuriously.
+    void wait(T expected, Order order = Order::seq_cst) const noexcept
+        requires(sizeof(T) == 4)
+    {
+        while(load(order) == expected) {
+            detail::atomic_wait(&value_, static_cast<u32>(expected));
+        }
+    }
+
+    void notify_one() noexcept
+        requires(sizeof(T) == 4)
+    {
+        detail::atomic_notify_one(&value_);
+    }
+
+    void notify_all() noexcept
+        requires(sizeof(T) == 4)
+    {
+        detail::atomic_notify_all(&value_);
+    }
+
+    template<Int I>
+        requires Int<T>
+    [[nodiscard]] I load(Order order = Order::seq_cst) const noexcept {
+        return static_cast<I>(load(order));
+    }
+
+private:
+#ifdef RPP_COMPILER_MSVC
+    template<typename F>
+    T update(F&& f) noexcept {
+        T prev = load();
+        for(;;) {
+            T next = detail::compare_exchange(&value_, prev, f(prev));
+            if(next == prev) return prev;
+            prev = next;
+        }
+    }
+#endif
+
+    alignas(sizeof(T)) T value_ = T{};
+
+    friend struct Reflect::Refl<Atomic>;
+};
+
+inline void fence(Order order = Order::seq_cst) noexcept {
+#ifdef RPP_COMPILER_MSVC
+    // Only a sequentially consistent fence needs an instruction on x64.
+    if(order == Order::seq_cst) {
+        __faststorefence();
+    } else {
+        _ReadWriteBarrier();
+    }
+#else
+    __atomic_thread_fence(detail::order(order));
+#endif
+}
+
+// Futex-based mutex that spins briefly before parking. Unlike pthread_mutex_t, it fits in 4
+// bytes and needs no initialization or cleanup.
 struct Mutex {
 
-    Mutex() noexcept;
-    ~Mutex() noexcept;
+    Mutex() noexcept = default;
+    ~Mutex() noexcept = default;
 
     Mutex(const Mutex&) noexcept = delete;
     Mutex(Mutex&&) noexcept = delete;
@@ -58,16 +313,29 @@ struct Mutex {
     Mutex& operator=(Mutex&&) noexcept = delete;
     Mutex& operator=(const Mutex&) noexcept = delete;
 
-    void lock() noexcept;
-    void unlock() noexcept;
-    [[nodiscard]] bool try_lock() noexcept;
+    void lock() noexcept {
+        if(state.compare_and_swap(UNLOCKED, LOCKED, Order::acquire) != UNLOCKED) lock_slow();
+    }
+    void unlock() noexcept {
+        if(state.exchange(UNLOCKED, Order::release) == CONTENDED) state.notify_one();
+    }
+    [[nodiscard]] bool try_lock() noexcept {
+        return state.compare_and_swap(UNLOCKED, LOCKED, Order::acquire) == UNLOCKED;
+    }
+
+    // Number of lock calls that found any mutex held. Always zero in release builds.
+    [[nodiscard]] static u64 contentions() noexcept;
 
 private:
-#ifdef RPP_OS_WINDOWS
-    void* lock_ = null;
-#else
-    pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
-#endif
+    constexpr static u32 UNLOCKED = 0;
+    constexpr static u32 LOCKED = 1;
+    // Locked, and other threads may be parked on it.
+    constexpr static u32 CONTENDED = 2;
+
+    void lock_slow() noexcept;
+    void lock_contended() noexcept;
+
+    Atomic<u32> state;
 
     friend struct Cond;
     friend struct Reflect::Refl<Mutex>;
@@ -94,64 +362,134 @@ private:
     friend struct Reflect::Refl<Lock>;
 };
 
-struct Atomic {
+struct Cond {
 
-    Atomic() noexcept = default;
-    ~Atomic() noexcept = default;
+    Cond() noexcept = default;
+    ~Cond() noexcept = default;
+
+    Cond(Cond&&) noexcept = delete;
+    Cond(const Cond&) noexcept = delete;
+
+    Cond& operator=(Cond&&) noexcept = delete;
+    Cond& operator=(const Cond&) noexcept = delete;
 
-    explicit Atomic(i64 value) noexcept : value_(value) {
+    void signal() noexcept {
+        sequence.fetch_add(1);
+        if(waiters.load() != 0) sequence.notify_one();
     }
+    void broadcast() noexcept {
+        sequence.fetch_add(1);
+        if(waiters.load() != 0) sequence.notify_all();
+    }
+    void wait(Mutex& mut) noexcept;
 
-    Atomic(const Atomic&) noexcept = default;
-    Atomic(Atomic&&) noexcept = default;
-    Atomic& operator=(const Atomic&) noexcept = default;
-    Atomic& operator=(Atomic&&) noexcept = default;
+private:
+    Atomic<u32> sequence;
+    Atomic<u32> waiters;
+
+    friend struct Reflect::Refl<Cond>;
+};
 
-    [[nodiscard]] i64 load() const noexcept;
-    i64 incr() noexcept;
-    i64 decr() noexcept;
-    i64 exchange(i64 value) noexcept;
-    [[nodiscard]] i64 compare_and_swap(i64 compare_with, i64 set_to) noexcept;
+// Writer-preferring reader-writer lock built on futexes. Readers block while a writer holds or
+// waits for the lock, so a reader must not re-acquire a read lock it already holds.
+struct RwLock {
 
-    template<Int I>
-    [[nodiscard]] I load() const noexcept {
-        return static_cast<I>(load());
+    RwLock() noexcept = default;
+    ~RwLock() noexcept;
+
+    RwLock(const RwLock&) noexcept = delete;
+    RwLock(RwLock&&) noexcept = delete;
+
+    RwLock& operator=(const RwLock&) noexcept = delete;
+    RwLock& operator=(RwLock&&) noexcept = delete;
+
+    void lock_shared() noexcept {
+        if(state.compare_and_swap(0, 1, Order::acquire) != 0) lock_shared_slow();
     }
+    void unlock_shared() noexcept {
+        u32 prev = state.fetch_sub(1, Order::release);
+        if((prev & READERS) == 1 && (prev & WRITERS_WAITING)) wake_writer();
+    }
+    [[nodiscard]] bool try_lock_shared() noexcept;
+
+    void lock() noexcept {
+        if(state.compare_and_swap(0, WRITER, Order::acquire) != 0) lock_slow();
+    }
+    void unlock() noexcept {
+        u32 prev = state.fetch_and(~(WRITER | WRITERS_WAITING | READERS_WAITING), Order::release);
+        if(prev & WRITERS_WAITING) wake_writer();
+        if(prev & READERS_WAITING) state.notify_all();
+    }
+    [[nodiscard]] bool try_lock() noexcept;
 
 private:
-    i64 value_ = 0;
+    constexpr static u32 READERS = (1u << 29) - 1;
+    constexpr static u32 WRITER = 1u << 29;
+    constexpr static u32 WRITERS_WAITING = 1u << 30;
+    constexpr static u32 READERS_WAITING = 1u << 31;
 
-    friend struct Reflect::Refl<Atomic>;
+    void lock_shared_slow() noexcept;
+    void lock_slow() noexcept;
+    void wake_writer() noexcept;
+
+    Atomic<u32> state;
+    // Writers sleep here rather than on state so waking one doesn't wake every reader.
+    Atomic<u32> writer_wakeups;
+
+    friend struct Reflect::Refl<RwLock>;
 };
 
-struct Cond {
+struct Read_Lock {
 
-    Cond() noexcept;
-    ~Cond() noexcept;
+    Read_Lock(RwLock& lock) noexcept : lock_(lock) {
+        lock_->lock_shared();
+    }
+    ~Read_Lock() noexcept {
+        if(lock_) lock_->unlock_shared();
+    }
 
-    Cond(Cond&&) noexcept = delete;
-    Cond(const Cond&) noexcept = delete;
+    Read_Lock(const Read_Lock&) noexcept = delete;
+    Read_Lock& operator=(const Read_Lock&) noexcept = delete;
 
-    Cond& operator=(Cond&&) noexcept = delete;
-    Cond& operator=(const Cond&) noexcept = delete;
+    Read_Lock(Read_Lock&& src) noexcept = default;
+    Read_Lock& operator=(Read_Lock&& src) noexcept = default;
 
-    void signal() noexcept;
-    void broadcast() noexcept;
-    void wait(Mutex& mut) noexcept;
+private:
+    Ref<RwLock> lock_;
+
+    friend struct Reflect::Refl<Read_Lock>;
+};
+
+struct Write_Lock {
+
+    Write_Lock(RwLock& lock) noexcept : lock_(lock) {
+        lock_->lock();
+    }
+    ~Write_Lock() noexcept {
+        if(lock_) lock_->unlock();
+    }
+
+    Write_Lock(const Write_Lock&) noexcept = delete;
+    Write_Lock& operator=(const Write_Lock&) noexcept = delete;
+
+    Write_Lock(Write_Lock&& src) noexcept = default;
+    Write_Lock& operator=(Write_Lock&& src) noexcept = default;
 
 private:
-#ifdef RPP_OS_WINDOWS
-    void* cond_ = null;
-#else
-    pthread_cond_t cond_ = PTHREAD_COND_INITIALIZER;
-#endif
+    Ref<RwLock> lock_;
 
-    friend struct Reflect::Refl<Cond>;
+    friend struct Reflect::Refl<Write_Lock>;
 };
 
 } // namespace Thread
 
-RPP_NAMED_RECORD(Thread::Atomic, "Atomic", RPP_FIELD(value_));
+template<typename T>
+RPP_NAMED_TEMPLATE_RECORD(::rpp::Thread::Atomic, "Atomic", T, RPP_FIELD(value_));
+
+RPP_NAMED_RECORD(Thread::RwLock, "RwLock", RPP_FIELD(state), RPP_FIELD(writer_wakeups));
+
+RPP_NAMED_ENUM(Thread::Order, "Order", seq_cst, RPP_CASE(relaxed), RPP_CASE(acquire),
+               RPP_CASE(release), RPP_CASE(acq_rel), RPP_CASE(seq_cst));
 
 RPP_NAMED_ENUM(Thread::Priority, "Priority", normal, RPP_CASE(low), RPP_CASE(normal),
                RPP_CASE(high), RPP_CASE(critical));
@@ -10,13 +10,223 @@ namespace rpp {
 template<typename T>
 struct Slice;
 
+namespace detail {
+
+// Element management shared by Vec and Small_Vec. Self holds data_, length_ and capacity_, and
+// its reserve decides where the elements live.
+template<typename T, Allocator A, typename Self>
+struct Vec_Base {
+
+    void grow() noexcept {
+        u64 capacity = self().capacity_;
+        self().reserve(capacity ? 2 * capacity : 8);
+    }
+
+    void clear() noexcept {
+        destroy(self().data_, 0, self().length_);
+        self().length_ = 0;
+    }
+
+    void extend(u64 additional_length) noexcept
+        requires Default_Constructable<T>
+    {
+        resize(self().length_ + additional_length);
+    }
+
+    void resize(u64 new_length) noexcept
+        requires Default_Constructable<T>
+    {
+        Self& v = self();
+        v.reserve(new_length);
+        if(new_length > v.length_) {
+            new(&v.data_[v.length_]) T[new_length - v.length_]{};
+        } else {
+            destroy(v.data_, new_length, v.length_);
+        }
+        v.length_ = new_length;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return self().length_ == 0;
+    }
+    [[nodiscard]] bool full() const noexcept {
+        return self().length_ == self().capacity_;
+    }
+
+    T& push(const T& value) noexcept
+        requires Copy_Constructable<T>
+    {
+        return push(T{value});
+    }
+
+    T& push(T&& value) noexcept
+        requires Move_Constructable<T>
+    {
+        Self& v = self();
+        if(full()) grow();
+        assert(v.length_ < v.capacity_);
+        new(&v.data_[v.length_]) T{move(value)};
+        return v.data_[v.length_++];
+    }
+
+    template<typename... Args>
+        requires Constructable<T, Args...>
+    T& emplace(Args&&... args) noexcept {
+        Self& v = self();
+        if(full()) grow();
+        assert(v.length_ < v.capacity_);
+        new(&v.data_[v.length_]) T{rpp::forward<Args>(args)...};
+        return v.data_[v.length_++];
+    }
+
+    void pop() noexcept {
+        Self& v = self();
+        assert(v.length_ > 0);
+        v.length_--;
+        destroy(v.data_, v.length_, v.length_ + 1);
+    }
+
+    [[nodiscard]] T& front() noexcept {
+        assert(self().length_ > 0);
+        return self().data_[0];
+    }
+    [[nodiscard]] const T& front() const noexcept {
+        assert(self().length_ > 0);
+        return self().data_[0];
+    }
+
+    [[nodiscard]] T& back() noexcept {
+        assert(self().length_ > 0);
+        return self().data_[self().length_ - 1];
+    }
+    [[nodiscard]] const T& back() const noexcept {
+        assert(self().length_ > 0);
+        return self().data_[self().length_ - 1];
+    }
+
+    [[nodiscard]] T& operator[](u64 idx) noexcept {
+        assert(idx < self().length_);
+        return self().data_[idx];
+    }
+    [[nodiscard]] const T& operator[](u64 idx) const noexcept {
+        assert(idx < self().length_);
+        return self().data_[idx];
+    }
+
+    [[nodiscard]] const T* begin() const noexcept {
+        return self().data_;
+    }
+    [[nodiscard]] const T* end() const noexcept {
+        return self().data_ + self().length_;
+    }
+    [[nodiscard]] T* begin() noexcept {
+        return self().data_;
+    }
+    [[nodiscard]] T* end() noexcept {
+        return self().data_ + self().length_;
+    }
+
+    [[nodiscard]] u64 length() const noexcept {
+        return self().length_;
+    }
+    [[nodiscard]] u64 capacity() const noexcept {
+        return self().capacity_;
+    }
+    [[nodiscard]] u64 bytes() const noexcept {
+        return self().length_ * sizeof(T);
+    }
+
+    [[nodiscard]] T* data() noexcept {
+        return self().data_;
+    }
+    [[nodiscard]] const T* data() const noexcept {
+        return self().data_;
+    }
+
+    [[nodiscard]] Slice<T> slice() const noexcept {
+        return Slice<T>{self().data_, self().length_};
+    }
+
+protected:
+    using Backing = Aligned_Adaptor<A, alignof(T)>;
+
+    [[nodiscard]] Self& self() noexcept {
+        return static_cast<Self&>(*this);
+    }
+    [[nodiscard]] const Self& self() const noexcept {
+        return static_cast<const Self&>(*this);
+    }
+
+    static void destroy(T* data, u64 begin, u64 end) noexcept {
+        if constexpr(Must_Destruct<T>) {
+            for(u64 i = begin; i < end; i++) {
+                data[i].~T();
+            }
+        }
+    }
+
+    // Moves the elements into uninitialized memory, leaving the source uninitialized.
+    static void relocate(T* dst, T* src, u64 length) noexcept {
+        if constexpr(Trivially_Movable<T>) {
+            Libc::memcpy((void*)dst, src, sizeof(T) * length);
+        } else {
+            static_assert(Move_Constructable<T>);
+            for(u64 i = 0; i < length; i++) {
+                new(&dst[i]) T{move(src[i])};
+                if constexpr(Must_Destruct<T>) src[i].~T();
+            }
+        }
+    }
+
+    // Copies or clones the elements into uninitialized memory.
+    void clone_to(T* dst) const noexcept
+        requires(Clone<T> || Copy_Constructable<T>)
+    {
+        const Self& v = self();
+        if constexpr(Trivially_Copyable<T>) {
+            Libc::memcpy(dst, v.data_, v.length_ * sizeof(T));
+        } else if constexpr(Clone<T>) {
+            for(u64 i = 0; i < v.length_; i++) {
+                new(&dst[i]) T{v.data_[i].clone()};
+            }
+        } else {
+            static_assert(Copy_Constructable<T>);
+            for(u64 i = 0; i < v.length_; i++) {
+                new(&dst[i]) T{v.data_[i]};
+            }
+        }
+    }
+
+    // Moves the elements into a buffer of new_capacity. Only a buffer the allocator owns is
+    // reallocated in place or freed.
+    void reallocate(u64 new_capacity, bool owned) noexcept {
+        Self& v = self();
+        if constexpr(Trivially_Movable<T> && Reallocating_Allocator<Backing>) {
+            if(owned) {
+                v.data_ = reinterpret_cast<T*>(Backing::realloc(v.data_, new_capacity * sizeof(T)));
+                v.capacity_ = new_capacity;
+                return;
+            }
+        }
+
+        T* new_data = reinterpret_cast<T*>(Backing::alloc(new_capacity * sizeof(T)));
+        if(v.data_ && new_data) relocate(new_data, v.data_, v.length_);
+        if(owned) Backing::free(v.data_);
+
+        v.capacity_ = new_capacity;
+        v.data_ = new_data;
+    }
+};
+
+} // namespace detail
+
 template<typename T, Allocator A = Mdefault>
-struct Vec {
+struct Vec : detail::Vec_Base<T, A, Vec<T, A>> {
 
     Vec() noexcept = default;
 
     explicit Vec(u64 capacity) noexcept
-        : data_(reinterpret_cast<T*>(A::alloc(capacity * sizeof(T)))), length_(0),
+        : data_(reinterpret_cast<T*>(Backing::alloc(capacity * sizeof(T)))), length_(0),
           capacity_(capacity) {
     }
 
@@ -24,7 +234,7 @@ struct Vec {
         requires Default_Constructable<T>
     {
         Vec ret;
-        ret.data_ = reinterpret_cast<T*>(A::alloc(length * sizeof(T)));
+        ret.data_ = reinterpret_cast<T*>(Backing::alloc(length * sizeof(T)));
         new(ret.data_) T[length]{};
         ret.capacity_ = length;
         ret.length_ = length;
@@ -35,7 +245,7 @@ struct Vec {
         requires All_Are<T, Ss...> && Move_Constructable<T>
     explicit Vec(Ss&&... init) noexcept {
         reserve(sizeof...(Ss));
-        (push(move(init)), ...);
+        (this->push(move(init)), ...);
     }
 
     Vec(const Vec& src) noexcept = delete;
@@ -61,14 +271,9 @@ struct Vec {
     }
 
     ~Vec() noexcept {
-        if constexpr(Must_Destruct<T>) {
-            for(u64 i = 0; i < length_; i++) {
-                data_[i].~T();
-            }
-        }
-        A::free(data_);
+        this->clear();
+        Backing::free(data_);
         data_ = null;
-        length_ = 0;
         capacity_ = 0;
     }
 
@@ -77,186 +282,133 @@ struct Vec {
         requires(Clone<T> || Copy_Constructable<T>)
     {
         Vec<T, B> ret(capacity_);
+        this->clone_to(ret.data_);
         ret.length_ = length_;
-        if constexpr(Trivially_Copyable<T>) {
-            Libc::memcpy(ret.data_, data_, length_ * sizeof(T));
-        } else if constexpr(Clone<T>) {
-            for(u64 i = 0; i < length_; i++) {
-                new(&ret.data_[i]) T{data_[i].clone()};
-            }
-        } else {
-            static_assert(Copy_Constructable<T>);
-            for(u64 i = 0; i < length_; i++) {
-                new(&ret.data_[i]) T{data_[i]};
-            }
-        }
         return ret;
     }
 
-    void grow() noexcept {
-        u64 new_capacity = capacity_ ? 2 * capacity_ : 8;
-        reserve(new_capacity);
+    void reserve(u64 new_capacity) noexcept {
+        if(new_capacity <= capacity_) return;
+        this->reallocate(new_capacity, data_ != null);
     }
 
-    void clear() noexcept {
-        if constexpr(Must_Destruct<T>) {
-            for(u64 i = 0; i < length_; i++) {
-                data_[i].~T();
-            }
-        }
-        length_ = 0;
+    void unsafe_fill() noexcept {
+        length_ = capacity_;
     }
 
-    void reserve(u64 new_capacity) noexcept {
-        if(new_capacity <= capacity_) return;
+private:
+    using Base = detail::Vec_Base<T, A, Vec>;
+    using typename Base::Backing;
+
+    T* data_ = null;
+    u64 length_ = 0;
+    u64 capacity_ = 0;
 
-        T* new_data = reinterpret_cast<T*>(A::alloc(new_capacity * sizeof(T)));
+    friend Base;
+    friend struct Reflect::Refl<Vec>;
+};
 
-        if(data_ && new_data) {
-            if constexpr(Trivially_Movable<T>) {
-                Libc::memcpy((void*)new_data, data_, sizeof(T) * length_);
-            } else {
-                static_assert(Move_Constructable<T>);
-                for(u64 i = 0; i < length_; i++) {
-                    new(&new_data[i]) T{move(data_[i])};
-                }
-            }
-        }
-        A::free(data_);
+// Vec with inline storage for the first N elements. Only spills to the allocator once it grows
+// past N, so short lists never allocate.
+template<typename T, u64 N, Allocator A = Mdefault>
+struct Small_Vec : detail::Vec_Base<T, A, Small_Vec<T, N, A>> {
+    static_assert(N > 0);
 
-        capacity_ = new_capacity;
-        data_ = new_data;
-    }
+    Small_Vec() noexcept = default;
 
-    void extend(u64 additional_length) noexcept
-        requires Default_Constructable<T>
-    {
-        resize(length_ + additional_length);
+    explicit Small_Vec(u64 capacity) noexcept {
+        reserve(capacity);
     }
 
-    void resize(u64 new_length) noexcept
+    [[nodiscard]] static Small_Vec make(u64 length) noexcept
         requires Default_Constructable<T>
     {
-        reserve(new_length);
-        if(new_length > length_) {
-            new(&data_[length_]) T[new_length - length_]{};
-        } else if constexpr(Must_Destruct<T>) {
-            for(u64 i = new_length; i < length_; i++) {
-                data_[i].~T();
-            }
-        }
-        length_ = new_length;
+        Small_Vec ret;
+        ret.resize(length);
+        return ret;
     }
 
-    [[nodiscard]] bool empty() const noexcept {
-        return length_ == 0;
-    }
-    [[nodiscard]] bool full() const noexcept {
-        return length_ == capacity_;
-    }
-    void unsafe_fill() noexcept {
-        length_ = capacity_;
+    template<typename... Ss>
+        requires All_Are<T, Ss...> && Move_Constructable<T>
+    explicit Small_Vec(Ss&&... init) noexcept {
+        reserve(sizeof...(Ss));
+        (this->push(move(init)), ...);
     }
 
-    T& push(const T& value) noexcept
-        requires Copy_Constructable<T>
-    {
-        return push(T{value});
-    }
+    Small_Vec(const Small_Vec& src) noexcept = delete;
+    Small_Vec& operator=(const Small_Vec& src) noexcept = delete;
 
-    T& push(T&& value) noexcept
-        requires Move_Constructable<T>
-    {
-        if(full()) grow();
-        assert(length_ < capacity_);
-        new(&data_[length_]) T{move(value)};
-        return data_[length_++];
+    Small_Vec(Small_Vec&& src) noexcept {
+        steal(move(src));
     }
-
-    template<typename... Args>
-        requires Constructable<T, Args...>
-    T& emplace(Args&&... args) noexcept {
-        if(full()) grow();
-        assert(length_ < capacity_);
-        new(&data_[length_]) T{rpp::forward<Args>(args)...};
-        return data_[length_++];
-    }
-
-    void pop() noexcept {
-        assert(length_ > 0);
-        length_--;
-        if constexpr(Must_Destruct<T>) {
-            data_[length_].~T();
-        }
+    Small_Vec& operator=(Small_Vec&& src) noexcept {
+        this->~Small_Vec();
+        steal(move(src));
+        return *this;
     }
 
-    [[nodiscard]] T& front() noexcept {
-        assert(length_ > 0);
-        return data_[0];
-    }
-    [[nodiscard]] const T& front() const noexcept {
-        assert(length_ > 0);
-        return data_[0];
+    ~Small_Vec() noexcept {
+        this->clear();
+        if(!is_inline()) Backing::free(data_);
+        data_ = inline_data();
+        capacity_ = N;
     }
 
-    [[nodiscard]] T& back() noexcept {
-        assert(length_ > 0);
-        return data_[length_ - 1];
-    }
-    [[nodiscard]] const T& back() const noexcept {
-        assert(length_ > 0);
-        return data_[length_ - 1];
+    template<Allocator B = A>
+    [[nodiscard]] Small_Vec<T, N, B> clone() const noexcept
+        requires(Clone<T> || Copy_Constructable<T>)
+    {
+        Small_Vec<T, N, B> ret(length_);
+        this->clone_to(ret.data_);
+        ret.length_ = length_;
+        return ret;
     }
 
-    [[nodiscard]] T& operator[](u64 idx) noexcept {
-        assert(idx < length_);
-        return data_[idx];
-    }
-    [[nodiscard]] const T& operator[](u64 idx) const noexcept {
-        assert(idx < length_);
-        return data_[idx];
+    void reserve(u64 new_capacity) noexcept {
+        if(new_capacity <= capacity_) return;
+        this->reallocate(new_capacity, !is_inline());
     }
 
-    [[nodiscard]] const T* begin() const noexcept {
-        return data_;
-    }
-    [[nodiscard]] const T* end() const noexcept {
-        return data_ + length_;
-    }
-    [[nodiscard]] T* begin() noexcept {
-        return data_;
-    }
-    [[nodiscard]] T* end() noexcept {
-        return data_ + length_;
+    [[nodiscard]] bool is_inline() const noexcept {
+        return data_ == inline_data();
     }
 
-    [[nodiscard]] u64 length() const noexcept {
-        return length_;
-    }
-    [[nodiscard]] u64 capacity() const noexcept {
-        return capacity_;
-    }
-    [[nodiscard]] u64 bytes() const noexcept {
-        return length_ * sizeof(T);
-    }
+private:
+    using Base = detail::Vec_Base<T, A, Small_Vec>;
+    using typename Base::Backing;
 
-    [[nodiscard]] T* data() noexcept {
-        return data_;
+    [[nodiscard]] T* inline_data() noexcept {
+        return reinterpret_cast<T*>(storage_);
     }
-    [[nodiscard]] const T* data() const noexcept {
-        return data_;
+    [[nodiscard]] const T* inline_data() const noexcept {
+        return reinterpret_cast<const T*>(storage_);
     }
 
-    [[nodiscard]] Slice<T> slice() const noexcept {
-        return Slice<T>{data_, length_};
+    // Heap buffers change hands; inline elements have to be moved over one by one.
+    void steal(Small_Vec&& src) noexcept {
+        if(src.is_inline()) {
+            data_ = inline_data();
+            capacity_ = N;
+            Base::relocate(data_, src.data_, src.length_);
+        } else {
+            data_ = src.data_;
+            capacity_ = src.capacity_;
+        }
+        length_ = src.length_;
+        src.data_ = src.inline_data();
+        src.length_ = 0;
+        src.capacity_ = N;
     }
 
-private:
-    T* data_ = null;
+    T* data_ = inline_data();
     u64 length_ = 0;
-    u64 capacity_ = 0;
+    u64 capacity_ = N;
+    alignas(T) u8 storage_[N * sizeof(T)];
 
-    friend struct Reflect::Refl<Vec>;
+    template<typename, u64, Allocator>
+    friend struct Small_Vec;
+    friend Base;
+    friend struct Reflect::Refl<Small_Vec>;
 };
 
 template<typename T>
@@ -270,6 +422,12 @@ struct Slice {
         length_ = v.length();
     }
 
+    template<u64 N, Allocator A>
+    explicit Slice(const Small_Vec<T, N, A>& v) noexcept {
+        data_ = v.data();
+        length_ = v.length();
+    }
+
     template<u64 N>
     constexpr explicit Slice(const Array<T, N>& a) noexcept {
         data_ = a.data();
@@ -359,26 +517,23 @@ template<typename T, Allocator A>
 RPP_TEMPLATE_RECORD(Vec, RPP_PACK(T, A), RPP_FIELD(data_), RPP_FIELD(length_),
                     RPP_FIELD(capacity_));
 
+template<typename T, u64 N, Allocator A>
+RPP_TEMPLATE_RECORD(Small_Vec, RPP_PACK(T, N, A), RPP_FIELD(data_), RPP_FIELD(length_),
+                    RPP_FIELD(capacity_));
+
 template<typename T>
 RPP_TEMPLATE_RECORD(Slice, T, RPP_FIELD(data_), RPP_FIELD(length_));
 
 namespace Format {
 
-template<Reflectable T, Allocator A>
-struct Measure<Vec<T, A>> {
-    [[nodiscard]] constexpr static u64 measure(const Vec<T, A>& vec) noexcept {
-        u64 length = 5;
-        for(u64 i = 0; i < vec.length(); i++) {
-            length += Measure<T>::measure(vec[i]);
-            if(i + 1 < vec.length()) length += 2;
-        }
-        return length;
-    }
-};
 template<Reflectable T>
 struct Measure<Slice<T>> {
     [[nodiscard]] static u64 measure(const Slice<T>& slice) noexcept {
-        u64 length = 7;
+        return 7 + elements(slice);
+    }
+    // Shared with Vec and Small_Vec, which only differ in their prefix.
+    [[nodiscard]] static u64 elements(const Slice<T>& slice) noexcept {
+        u64 length = 0;
         for(u64 i = 0; i < slice.length(); i++) {
             length += Measure<T>::measure(slice[i]);
             if(i + 1 < slice.length()) length += 2;
@@ -386,22 +541,27 @@ struct Measure<Slice<T>> {
         return length;
     }
 };
-
-template<Allocator O, Reflectable T, Allocator A>
-struct Write<O, Vec<T, A>> {
-    [[nodiscard]] static u64 write(String<O>& output, u64 idx, const Vec<T, A>& vec) noexcept {
-        idx = output.write(idx, "Vec["_v);
-        for(u64 i = 0; i < vec.length(); i++) {
-            idx = Write<O, T>::write(output, idx, vec[i]);
-            if(i + 1 < vec.length()) idx = output.write(idx, ", "_v);
-        }
-        return output.write(idx, ']');
+template<Reflectable T, Allocator A>
+struct Measure<Vec<T, A>> {
+    [[nodiscard]] static u64 measure(const Vec<T, A>& vec) noexcept {
+        return 5 + Measure<Slice<T>>::elements(vec.slice());
     }
 };
+template<Reflectable T, u64 N, Allocator A>
+struct Measure<Small_Vec<T, N, A>> {
+    [[nodiscard]] static u64 measure(const Small_Vec<T, N, A>& vec) noexcept {
+        return 11 + Measure<Slice<T>>::elements(vec.slice());
+    }
+};
+
 template<Allocator O, Reflectable T>
 struct Write<O, Slice<T>> {
     [[nodiscard]] static u64 write(String<O>& output, u64 idx, const Slice<T>& slice) noexcept {
         idx = output.write(idx, "Slice["_v);
+        return elements(output, idx, slice);
+    }
+    // Writes the elements and the closing bracket after a container's own prefix.
+    [[nodiscard]] static u64 elements(String<O>& output, u64 idx, const Slice<T>& slice) noexcept {
         for(u64 i = 0; i < slice.length(); i++) {
             idx = Write<O, T>::write(output, idx, slice[i]);
             if(i + 1 < slice.length()) idx = output.write(idx, ", "_v);
@@ -409,6 +569,21 @@ struct Write<O, Slice<T>> {
         return output.write(idx, ']');
     }
 };
+template<Allocator O, Reflectable T, Allocator A>
+struct Write<O, Vec<T, A>> {
+    [[nodiscard]] static u64 write(String<O>& output, u64 idx, const Vec<T, A>& vec) noexcept {
+        idx = output.write(idx, "Vec["_v);
+        return Write<O, Slice<T>>::elements(output, idx, vec.slice());
+    }
+};
+template<Allocator O, Reflectable T, u64 N, Allocator A>
+struct Write<O, Small_Vec<T, N, A>> {
+    [[nodiscard]] static u64 write(String<O>& output, u64 idx,
+                                   const Small_Vec<T, N, A>& vec) noexcept {
+        idx = output.write(idx, "Small_Vec["_v);
+        return Write<O, Slice<T>>::elements(output, idx, vec.slice());
+    }
+};
 
 } // namespace Format
 
@@ -0,0 +1,49 @@
+
+#include "../base.h"
+
+#include <windows.h>
+
+namespace rpp {
+
+[[nodiscard]] u64 sys_page_size() noexcept {
+    static u64 page_size = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<u64>(info.dwPageSize);
+    }();
+    return page_size;
+}
+
+[[nodiscard]] void* sys_alloc_huge(u64 size) noexcept {
+    // Large pages require SeLockMemoryPrivilege and can't be freed with the CRT, so the hint is
+    // ignored here.
+    return sys_alloc(size);
+}
+
+[[nodiscard]] void* sys_reserve(u64 size) noexcept {
+    void* ret = VirtualAlloc(null, size, MEM_RESERVE, PAGE_NOACCESS);
+    if(!ret) {
+        die("Failed to reserve % bytes: %", size, Log::sys_error());
+    }
+    return ret;
+}
+
+void sys_commit(void* mem, u64 size) noexcept {
+    if(!VirtualAlloc(mem, size, MEM_COMMIT, PAGE_READWRITE)) {
+        die("Failed to commit % bytes: %", size, Log::sys_error());
+    }
+}
+
+void sys_decommit(void* mem, u64 size) noexcept {
+    if(!VirtualFree(mem, size, MEM_DECOMMIT)) {
+        die("Failed to decommit % bytes: %", size, Log::sys_error());
+    }
+}
+
+void sys_release(void* mem, u64) noexcept {
+    if(!VirtualFree(mem, 0, MEM_RELEASE)) {
+        die("Failed to release reservation: %", Log::sys_error());
+    }
+}
+
+} // namespace rpp
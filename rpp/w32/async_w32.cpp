@@ -7,32 +7,36 @@ namespace rpp::Async {
 
 static_assert(sizeof(HANDLE) == sizeof(void*));
 
-Event::Event() noexcept {
+[[nodiscard]] Event Event::make_sys() noexcept {
     HANDLE event = CreateEventEx(null, null, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS);
     if(!event) {
         die("Failed to create event: %", Log::sys_error());
     }
-    event_ = reinterpret_cast<void*>(event);
+    return Event{reinterpret_cast<void*>(event)};
 }
 
 Event::Event(Event&& other) noexcept {
+    uptr head = other.state.exchange(0, Thread::Order::relaxed);
+    assert(head == 0 || head == SIGNALED);
+    state.store(head, Thread::Order::relaxed);
     event_ = other.event_;
     other.event_ = null;
 }
 
 Event& Event::operator=(Event&& other) noexcept {
     this->~Event();
+    uptr head = other.state.exchange(0, Thread::Order::relaxed);
+    assert(head == 0 || head == SIGNALED);
+    state.store(head, Thread::Order::relaxed);
     event_ = other.event_;
     other.event_ = null;
     return *this;
 }
 
-Event::~Event() noexcept {
+void Event::close_sys() noexcept {
     HANDLE event = reinterpret_cast<HANDLE>(event_);
-    if(event) {
-        BOOL ret = CloseHandle(event);
-        assert(ret);
-    }
+    BOOL ret = CloseHandle(event);
+    assert(ret);
     event_ = null;
 }
 
@@ -41,7 +45,7 @@ Event::~Event() noexcept {
     return Event{handle};
 }
 
-void Event::reset() const noexcept {
+void Event::reset_sys() noexcept {
     HANDLE event = reinterpret_cast<HANDLE>(event_);
     BOOL ret = ResetEvent(event);
     if(!ret) {
@@ -49,7 +53,7 @@ void Event::reset() const noexcept {
     }
 }
 
-void Event::signal() const noexcept {
+void Event::signal_sys() noexcept {
     HANDLE event = reinterpret_cast<HANDLE>(event_);
     BOOL ret = SetEvent(event);
     if(!ret) {
@@ -57,7 +61,7 @@ void Event::signal() const noexcept {
     }
 }
 
-[[nodiscard]] bool Event::try_wait() const noexcept {
+[[nodiscard]] bool Event::try_wait_sys() const noexcept {
     HANDLE event = reinterpret_cast<HANDLE>(event_);
     DWORD ret = WaitForSingleObjectEx(event, 0, false);
     if(ret == WAIT_OBJECT_0) {
@@ -70,10 +74,14 @@ void Event::signal() const noexcept {
 }
 
 [[nodiscard]] u64 Event::wait_any(Slice<Event> events) noexcept {
-    assert(!events.empty());
-    const HANDLE* handles = reinterpret_cast<const HANDLE*>(events.data());
-    DWORD ret = WaitForMultipleObjectsEx(static_cast<DWORD>(events.length()), handles, false,
-                                         INFINITE, false);
+    assert(!events.empty() && events.length() <= MAXIMUM_WAIT_OBJECTS);
+    Array<HANDLE, MAXIMUM_WAIT_OBJECTS> handles;
+    for(u64 i = 0; i < events.length(); i++) {
+        assert(events[i].is_sys());
+        handles[i] = reinterpret_cast<HANDLE>(events[i].event_);
+    }
+    DWORD ret = WaitForMultipleObjectsEx(static_cast<DWORD>(events.length()), handles.data(),
+                                         false, INFINITE, false);
     if(ret < WAIT_OBJECT_0 || ret >= WAIT_OBJECT_0 + events.length()) {
         die("Failed to wait on events: % (%)", static_cast<u32>(ret), Log::sys_error());
     }
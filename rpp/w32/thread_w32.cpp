@@ -46,6 +46,67 @@ void pause() noexcept {
     return static_cast<u64>(info.dwNumberOfProcessors);
 }
 
+[[nodiscard]] Vec<Cpu, Alloc> topology() noexcept {
+    Vec<Cpu, Alloc> cpus;
+
+    // Only processor group 0 is visible to set_affinity, so only it is reported.
+    u64 n = Math::min(hardware_threads(), static_cast<u64>(64));
+    for(u64 id = 0; id < n; id++) {
+        cpus.push(Cpu{id, id, 0, 0});
+    }
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, null, &length);
+    if(GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+        warn("Failed to query processor topology: %", Log::sys_error());
+        return cpus;
+    }
+
+    Vec<u8, Alloc> buffer(length);
+    buffer.resize(length);
+    if(!GetLogicalProcessorInformationEx(
+           RelationAll, reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data()),
+           &length)) {
+        warn("Failed to query processor topology: %", Log::sys_error());
+        return cpus;
+    }
+
+    auto assign = [&](const GROUP_AFFINITY& group, auto&& f) {
+        if(group.Group != 0) return;
+        for(auto& cpu : cpus) {
+            if(group.Mask & (static_cast<KAFFINITY>(1) << cpu.id)) f(cpu);
+        }
+    };
+
+    u64 core = 0, package = 0;
+    for(DWORD offset = 0; offset < length;) {
+        auto info =
+            reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        switch(info->Relationship) {
+        case RelationProcessorCore: {
+            for(WORD i = 0; i < info->Processor.GroupCount; i++) {
+                assign(info->Processor.GroupMask[i], [&](Cpu& cpu) { cpu.core = core; });
+            }
+            core++;
+        } break;
+        case RelationProcessorPackage: {
+            for(WORD i = 0; i < info->Processor.GroupCount; i++) {
+                assign(info->Processor.GroupMask[i], [&](Cpu& cpu) { cpu.package = package; });
+            }
+            package++;
+        } break;
+        case RelationNumaNode: {
+            u64 node = info->NumaNode.NodeNumber;
+            assign(info->NumaNode.GroupMask, [&](Cpu& cpu) { cpu.node = node; });
+        } break;
+        default: break;
+        }
+        offset += info->Size;
+    }
+
+    return cpus;
+}
+
 void set_priority(Priority p) noexcept {
     int value;
     switch(p) {
@@ -74,14 +135,22 @@ void set_affinity(u64 core) noexcept {
     }
 }
 
-static_assert(sizeof(SRWLOCK) == sizeof(void*));
-static_assert(sizeof(CONDITION_VARIABLE) == sizeof(void*));
 static_assert(sizeof(HANDLE) == sizeof(OS_Thread));
 
+// The flag is 0 while unsignaled, FLAG_PARKED once a thread may be sleeping on it, and
+// FLAG_SIGNALED afterwards. signal only wakes if someone parked.
+static constexpr i16 FLAG_SIGNALED = 1;
+static constexpr i16 FLAG_PARKED = 2;
+
 void Flag::block() noexcept {
-    u16 zero = 0;
-    while(value_ == 0) {
-        bool ret = WaitOnAddress(&value_, &zero, sizeof(value_), INFINITE);
+    for(;;) {
+        i16 value = value_;
+        if(value == FLAG_SIGNALED) return;
+        if(value == 0 && InterlockedCompareExchange16(&value_, FLAG_PARKED, 0) != 0) {
+            continue;
+        }
+        i16 parked = FLAG_PARKED;
+        bool ret = WaitOnAddress(&value_, &parked, sizeof(value_), INFINITE);
         if(!ret) {
             die("Failed to wait on address: %", Log::sys_error());
         }
@@ -89,76 +158,27 @@ void Flag::block() noexcept {
 }
 
 void Flag::signal() noexcept {
-    InterlockedIncrement16(&value_);
+    if(InterlockedExchange16(&value_, FLAG_SIGNALED) != FLAG_PARKED) return;
     WakeByAddressAll(&value_);
 }
 
 [[nodiscard]] bool Flag::ready() noexcept {
-    return value_ != 0;
-}
-
-Mutex::Mutex() noexcept {
-    InitializeSRWLock(reinterpret_cast<PSRWLOCK>(&lock_));
-}
-
-Mutex::~Mutex() noexcept {
-    lock_ = null;
-}
-
-void Mutex::lock() noexcept {
-    AcquireSRWLockExclusive(reinterpret_cast<PSRWLOCK>(&lock_));
-}
-
-void Mutex::unlock() noexcept {
-    ReleaseSRWLockExclusive(reinterpret_cast<PSRWLOCK>(&lock_));
-}
-
-[[nodiscard]] bool Mutex::try_lock() noexcept {
-    return TryAcquireSRWLockExclusive(reinterpret_cast<PSRWLOCK>(&lock_));
-}
-
-[[nodiscard]] i64 Atomic::load() const noexcept {
-    return value_;
-}
-
-i64 Atomic::incr() noexcept {
-    return InterlockedIncrement64(&value_);
-}
-
-i64 Atomic::decr() noexcept {
-    return InterlockedDecrement64(&value_);
-}
-
-i64 Atomic::exchange(i64 value) noexcept {
-    return InterlockedExchange64(&value_, value);
-}
-
-[[nodiscard]] i64 Atomic::compare_and_swap(i64 compare_with, i64 set_to) noexcept {
-    return InterlockedCompareExchange64(&value_, set_to, compare_with);
-}
-
-Cond::Cond() noexcept {
-    InitializeConditionVariable(reinterpret_cast<PCONDITION_VARIABLE>(&cond_));
-}
-
-Cond::~Cond() noexcept {
-    cond_ = CONDITION_VARIABLE_INIT;
+    return value_ == FLAG_SIGNALED;
 }
 
-void Cond::wait(Mutex& mut) noexcept {
-    bool ret = SleepConditionVariableSRW(reinterpret_cast<PCONDITION_VARIABLE>(&cond_),
-                                         reinterpret_cast<PSRWLOCK>(&mut.lock_), INFINITE, 0);
+void detail::atomic_wait(const void* address, u32 expected) noexcept {
+    bool ret = WaitOnAddress(const_cast<void*>(address), &expected, sizeof(expected), INFINITE);
     if(!ret) {
-        die("Failed to wait on cond: %", Log::sys_error());
+        die("Failed to wait on address: %", Log::sys_error());
     }
 }
 
-void Cond::signal() noexcept {
-    WakeConditionVariable(reinterpret_cast<PCONDITION_VARIABLE>(&cond_));
+void detail::atomic_notify_one(const void* address) noexcept {
+    WakeByAddressSingle(const_cast<void*>(address));
 }
 
-void Cond::broadcast() noexcept {
-    WakeAllConditionVariable(reinterpret_cast<PCONDITION_VARIABLE>(&cond_));
+void detail::atomic_notify_all(const void* address) noexcept {
+    WakeByAddressAll(const_cast<void*>(address));
 }
 
 [[nodiscard]] Id sys_id(OS_Thread thread_) noexcept {
@@ -1,8 +1,21 @@
 
 #include "test.h"
 
+#include <rpp/heap.h>
 #include <rpp/rc.h>
 
+struct alignas(64) Padded {
+    u64 value = 0;
+    bool operator<(const Padded& other) const noexcept {
+        return value < other.value;
+    }
+};
+
+template<typename T>
+[[nodiscard]] bool aligned(const T* ptr) noexcept {
+    return reinterpret_cast<uptr>(ptr) % alignof(T) == 0;
+}
+
 i32 main() {
     Profile::begin_frame();
     {
@@ -23,6 +36,63 @@ i32 main() {
                 }
             }
         }
+        assert(Region_Allocator::size() == 0);
+        assert(Region_Allocator::high_water() >= Math::MB(8));
+        Region(R0) {
+            // Memory is contiguous across scopes and reused after they end.
+            u8* a = reinterpret_cast<u8*>(Mregion<R0>::alloc(16));
+            Region(R1) {
+                u8* b = reinterpret_cast<u8*>(Mregion<R1>::alloc(16));
+                assert(b == a + 16);
+                assert(Region_Allocator::size() == 32);
+            }
+            Region(R1) {
+                u8* c = reinterpret_cast<u8*>(Mregion<R1>::alloc(Math::MB(64)));
+                assert(c == a + 16);
+                c[Math::MB(64) - 1] = 1;
+            }
+            assert(Region_Allocator::size() == 16);
+        }
+        Trace("Aligned") {
+            Vec<Padded> vec;
+            for(u64 i = 0; i < 100; i++) {
+                vec.push(Padded{i});
+                assert(aligned(vec.data()));
+            }
+            Queue<Padded> queue;
+            for(u64 i = 0; i < 100; i++) queue.push(Padded{i});
+            assert(aligned(&queue.front()));
+            Heap<Padded> heap;
+            for(u64 i = 0; i < 100; i++) heap.push(Padded{i});
+            assert(aligned(&heap.top()));
+            Map<u64, Padded> map;
+            for(u64 i = 0; i < 100; i++) map.insert(i, Padded{i});
+            assert(aligned(&**map.try_get(7)));
+            Box<Padded> box{Padded{1}};
+            assert(aligned(&*box));
+
+            Region(R) {
+                // Regions don't align themselves, so this over-allocates.
+                auto bytes = Vec<u8, Mregion<R>>::make(3);
+                auto padded = Vec<Padded, Mregion<R>>::make(10);
+                assert(aligned(padded.data()));
+            }
+
+            using Mhuge = Mallocator<"Huge", true, true>;
+            auto huge = Vec<u8, Mhuge>::make(Math::MB(4));
+#ifdef RPP_OS_LINUX
+            assert(reinterpret_cast<uptr>(huge.data()) % Math::MB(2) == 0);
+#endif
+            huge[Math::MB(4) - 1] = 1;
+
+            // Growing copies into a new huge allocation instead of reallocating.
+            static_assert(!Reallocating_Allocator<Mhuge>);
+            huge.resize(Math::MB(8));
+#ifdef RPP_OS_LINUX
+            assert(reinterpret_cast<uptr>(huge.data()) % Math::MB(2) == 0);
+#endif
+            assert(huge[Math::MB(4) - 1] == 1);
+        }
         Trace("Alloc0") {
             using A = Mallocator<"Test">;
             void* ptr = A::alloc(100);
@@ -0,0 +1,64 @@
+
+#include "test.h"
+
+#include <rpp/arena.h>
+#include <rpp/pool.h>
+
+i32 main() {
+    Test test{"empty"_v};
+    {
+        Arena arena;
+        {
+            Arena::Scope scope{arena};
+            assert(Arena::current() == &arena);
+
+            Vec<i32, Marena> vec;
+            for(i32 i = 0; i < 1000; i++) vec.push(i);
+            for(i32 i = 0; i < 1000; i++) assert(vec[i] == i);
+
+            Map<i32, i32, Marena> map;
+            for(i32 i = 0; i < 100; i++) map.insert(i, i * 2);
+            for(i32 i = 0; i < 100; i++) assert(**map.try_get(i) == i * 2);
+
+            String<Marena> string = "Hello arena"_v.string<Marena>();
+            assert(string.view() == "Hello arena"_v);
+
+            // Larger than a chunk.
+            auto big = Vec<u8, Marena>::make(Math::MB(1));
+            assert(reinterpret_cast<uptr>(big.data()) % 16 == 0);
+        }
+        assert(Arena::current() == null);
+        assert(arena.size() > 0);
+        arena.reset();
+        assert(arena.size() == 0);
+    }
+    {
+        Async::Pool pool;
+        Arena arena;
+
+        // Coroutines on any worker allocate from the same arena.
+        auto job = [](Async::Pool<>& pool, Arena& arena, u64 i) -> Async::Task<u64> {
+            co_await pool.suspend();
+            u64 sum = 0;
+            {
+                Arena::Scope scope{arena};
+                Vec<u64, Marena> values;
+                for(u64 j = 0; j < 1000; j++) values.push(i + j);
+                for(u64 value : values) sum += value;
+            }
+            co_return sum;
+        };
+
+        for(u64 round = 0; round < 4; round++) {
+            Vec<Async::Task<u64>> jobs;
+            for(u64 i = 0; i < 16; i++) {
+                jobs.push(job(pool, arena, i));
+            }
+            for(u64 i = 0; i < 16; i++) {
+                assert(jobs[i].block() == i * 1000 + 999 * 1000 / 2);
+            }
+            arena.reset();
+        }
+    }
+    return 0;
+}
@@ -4,6 +4,19 @@
 #include <rpp/heap.h>
 #include <rpp/stack.h>
 
+struct Counted {
+    constexpr static Literal name = "Counted";
+    static inline u64 allocs = 0;
+
+    [[nodiscard]] static void* alloc(u64 size) noexcept {
+        allocs++;
+        return Mdefault::alloc(size);
+    }
+    static void free(void* mem) noexcept {
+        Mdefault::free(mem);
+    }
+};
+
 struct X {
     X(i32 i) : i{i} {
     }
@@ -129,6 +142,58 @@ i32 main() {
         (void)s3;
         (void)s5;
     }
+    Trace("Small_Vec") {
+        Small_Vec<i32, 4, Counted> v;
+        for(i32 i = 0; i < 4; i++) v.push(i);
+        assert(v.is_inline());
+        assert(v.length() == 4);
+        assert(Counted::allocs == 0);
+
+        Small_Vec<i32, 4, Counted> v2 = v.clone();
+        Small_Vec<i32, 4, Counted> v3 = move(v2);
+        assert(v3.is_inline() && v3.length() == 4 && v3[3] == 3);
+        assert(v2.empty() && v2.is_inline());
+        assert(Counted::allocs == 0);
+
+        // Spills to the allocator once it outgrows the inline buffer.
+        v.push(4);
+        assert(!v.is_inline());
+        assert(Counted::allocs == 1);
+        for(i32 i = 5; i < 100; i++) v.push(i);
+        for(i32 i = 0; i < 100; i++) assert(v[i] == i);
+
+        Small_Vec<i32, 4, Counted> v4 = move(v);
+        assert(!v4.is_inline() && v4.length() == 100);
+        assert(v.is_inline() && v.empty());
+        v.push(1);
+        v4 = move(v);
+        assert(v4.is_inline() && v4.length() == 1 && v4.front() == 1);
+
+        Slice<i32> s{v3};
+        assert(s.length() == 4);
+        assert(v3.slice().length() == 4);
+
+        Small_Vec<String_View, 2> sv{"Hello"_v, "World"_v, "!"_v};
+        assert(sv.length() == 3 && !sv.is_inline());
+        Small_Vec<String_View, 2> sv2 = sv.clone();
+        assert(sv2.back() == "!"_v);
+
+        Small_Vec<Function<void()>, 2> vf;
+        for(i32 i = 0; i < 10; i++) {
+            vf.push([]() { info("Hello"); });
+        }
+        Small_Vec<Function<void()>, 2> vf2 = move(vf);
+        assert(vf2.length() == 10);
+
+        Small_Vec<Function<void()>, 16> vf3;
+        vf3.push([]() {});
+        Small_Vec<Function<void()>, 16> vf4 = move(vf3);
+        vf4[0]();
+
+        Small_Vec<u64, 2> r = Small_Vec<u64, 2>::make(3);
+        r.resize(1);
+        assert(r.length() == 1 && r[0] == 0);
+    }
     Trace("Stack") {
         Stack<i32> v;
         v.push(1);
@@ -308,5 +373,50 @@ i32 main() {
             vf.push({[]() { info("Hello"); }});
         }
     }
+    {
+        // Trivially movable contents grow by reallocating in place.
+        static_assert(Reallocating_Allocator<Mdefault>);
+        Vec<u64> v;
+        for(u64 i = 0; i < 100000; i++) v.push(i);
+        for(u64 i = 0; i < 100000; i++) assert(v[i] == i);
+
+        Heap<u64> h;
+        for(u64 i = 0; i < 1000; i++) h.push(u64{i});
+        for(u64 i = 0; i < 1000; i++) {
+            assert(h.top() == i);
+            h.pop();
+        }
+
+        // Grow while wrapped around the end of the buffer.
+        Queue<u64> q;
+        q.reserve(8);
+        for(u64 i = 0; i < 6; i++) q.push(i);
+        for(u64 i = 0; i < 4; i++) q.pop();
+        for(u64 i = 6; i < 10; i++) q.push(i);
+        for(u64 i = 10; i < 100; i++) q.push(i);
+        for(u64 i = 4; i < 100; i++) {
+            assert(q.front() == i);
+            q.pop();
+        }
+        assert(q.empty());
+
+        // Grow when full and unwrapped, and when the older segment is the smaller one.
+        Queue<u64> full;
+        full.reserve(8);
+        for(u64 i = 0; i < 9; i++) full.push(i);
+        for(u64 i = 0; i < 9; i++) {
+            assert(full.front() == i);
+            full.pop();
+        }
+        Queue<u64> older;
+        older.reserve(8);
+        for(u64 i = 0; i < 8; i++) older.push(i);
+        for(u64 i = 0; i < 7; i++) older.pop();
+        for(u64 i = 8; i < 20; i++) older.push(i);
+        for(u64 i = 7; i < 20; i++) {
+            assert(older.front() == i);
+            older.pop();
+        }
+    }
     return 0;
 }
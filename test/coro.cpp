@@ -99,6 +99,55 @@ i32 main() {
             assert(task.done());
             assert(task.block() == 1);
         }
+        {
+            auto co1 = [](i32 i) -> Async::Task<i32> {
+                co_await Async::Suspend{};
+                co_return i;
+            };
+
+            auto job0 = co1(1);
+            auto job1 = co1(2);
+
+            auto co2 = [&job0, &job1]() -> Async::Task<i32> {
+                co_await Async::when_all(job0, job1);
+                info("Coroutine 10 joined");
+                co_return co_await job0 + co_await job1;
+            };
+
+            Async::Task<i32> task = co2();
+            assert(!task.done());
+            job1.resume();
+            assert(!task.done());
+            job0.resume();
+            assert(task.done());
+            assert(task.block() == 3);
+        }
+        {
+            auto co1 = [](i32 i) -> Async::Task<i32> {
+                co_await Async::Suspend{};
+                co_return i;
+            };
+
+            auto job0 = co1(1);
+            auto job1 = co1(2);
+            auto job2 = co1(3);
+
+            auto co2 = [&job0, &job1, &job2]() -> Async::Task<u64> {
+                u64 first = co_await Async::when_any(job0, job1, job2);
+                info("Coroutine 11 got %", first);
+                co_return first;
+            };
+
+            Async::Task<u64> task = co2();
+            assert(!task.done());
+            job2.resume();
+            assert(task.done());
+            assert(task.block() == 2);
+            job0.resume();
+            job1.resume();
+            assert(job0.block() == 1);
+            assert(job1.block() == 2);
+        }
     }
     return 0;
 }
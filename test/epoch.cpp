@@ -0,0 +1,99 @@
+
+#include "test.h"
+
+#include <rpp/epoch.h>
+#include <rpp/pool.h>
+#include <rpp/thread.h>
+
+static Thread::Atomic<u64> g_destroyed;
+
+struct Node {
+    explicit Node(u64 value) noexcept : value{value}, check{~value} {
+    }
+    ~Node() noexcept {
+        // Poison the node so a use after free fails the readers' check.
+        value = 0;
+        check = 0;
+        g_destroyed.incr(Thread::Order::relaxed);
+    }
+
+    u64 value = 0;
+    u64 check = 0;
+};
+
+using Node_Alloc = Mallocator<"Node">;
+
+i32 main() {
+    Test test{"empty"_v};
+    {
+        Epoch::Guard guard;
+        {
+            Epoch::Guard nested;
+        }
+    }
+    {
+        constexpr u64 writers = 2;
+        constexpr u64 readers = 2;
+        constexpr u64 swaps = 20000;
+
+        Thread::Atomic<Node*> shared{Pool_Adaptor<Node_Alloc>::make<Node>(0)};
+        Thread::Atomic<u64> done;
+        g_destroyed.store(0);
+
+        Vec<Thread::Future<void>> tasks;
+        for(u64 i = 0; i < writers; i++) {
+            tasks.push(Thread::spawn([&, i]() {
+                for(u64 j = 0; j < swaps; j++) {
+                    Node* next = Pool_Adaptor<Node_Alloc>::make<Node>(i * swaps + j + 1);
+                    Node* prev = shared.exchange(next, Thread::Order::acq_rel);
+                    Epoch::retire<Node, Node_Alloc>(prev);
+                }
+                Epoch::synchronize();
+                assert(Epoch::pending() == 0);
+                done.incr();
+            }));
+        }
+        for(u64 i = 0; i < readers; i++) {
+            tasks.push(Thread::spawn([&]() {
+                while(done.load() < writers) {
+                    Epoch::Guard guard;
+                    for(u64 j = 0; j < 16; j++) {
+                        Node* node = shared.load(Thread::Order::acquire);
+                        assert(node->check == ~node->value);
+                    }
+                }
+            }));
+        }
+        for(auto& task : tasks) {
+            task->block();
+        }
+
+        Epoch::retire<Node, Node_Alloc>(shared.exchange(null));
+        Epoch::synchronize();
+        assert(Epoch::pending() == 0);
+        assert(g_destroyed.load() == writers * swaps + 1);
+    }
+    {
+        Async::Pool pool;
+        g_destroyed.store(0);
+
+        auto job = [](Async::Pool<>& pool) -> Async::Task<void> {
+            co_await pool.suspend();
+            for(u64 i = 0; i < 100; i++) {
+                Epoch::retire<Node, Node_Alloc>(Pool_Adaptor<Node_Alloc>::make<Node>(i));
+            }
+        };
+
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 8; i++) {
+            jobs.push(job(pool));
+        }
+        for(auto& job : jobs) {
+            job.block();
+        }
+    }
+    // The pool's workers exited, handing over whatever they had not yet freed.
+    Epoch::synchronize();
+    assert(g_destroyed.load() == 800);
+    return 0;
+}
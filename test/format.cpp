@@ -86,6 +86,8 @@ i32 main() {
 
         info("% %", format_typename<Vec<i32>>(), Vec<i32>{1, 2});
         info("%", Vec<i32>{});
+        info("% %", format_typename<Small_Vec<i32, 4>>(), Small_Vec<i32, 4>{1, 2});
+        info("%", Small_Vec<i32, 1>{1, 2});
 
         info("% %", format_typename<Slice<i32>>(), Slice<i32>{1, 2});
         info("%", Slice<i32>{});
@@ -108,7 +110,7 @@ i32 main() {
         info("% %", format_typename<Arc<i32>>(), Arc<i32>{});
         info("%", Arc<i32>{5});
 
-        info("%", Thread::Atomic{3});
+        info("%", Thread::Atomic<i64>{3});
 
         info("%", Vecs{Vec<i32>{1, 2}, Vec<u32>{3u, 4u}});
         info("% %", format_typename<Array<Vec<i32>, 2>>(),
@@ -149,5 +151,48 @@ i32 main() {
                        9.0f, 10.0f, 11.0f, 12.0f, //
                        13.0f, 14.0f, 15.0f, 16.0f});
     }
+    {
+        Region(R) {
+            u8 buffer[16];
+            String_Builder<Mregion<R>> b{buffer};
+            assert(format_to(b, "%% % %"_v, -12, 34u) == "% -12 34"_v);
+            assert(!b.spilled());
+
+            b.clear();
+            Ints ints{-1, 65535};
+            assert(format_to(b, "[%] %"_v, ints, 1.5f) ==
+                   format<Mregion<R>>("[%] %"_v, ints, 1.5f));
+            assert(b.spilled());
+
+            b.clear();
+            i64 small = Limits<i64>::min();
+            u64 big = Limits<u64>::max();
+            assert(format_to(b, "% %"_v, small, big) == format<Mregion<R>>("% %"_v, small, big));
+
+            b.clear();
+            Vec<i32> vec{1, 2, 3};
+            String_View view = "view"_v;
+            assert(format_to(b, "% % % %"_v, vec, view, Reflect::Kind::enum_, 'c') ==
+                   format<Mregion<R>>("% % % %"_v, vec, view, Reflect::Kind::enum_, 'c'));
+        }
+    }
+    {
+        using F = decltype("%%a % b%%%"_f);
+        static_assert(F::arguments == 2);
+        static_assert(F::length == 6);
+        assert(F::segment<0>() == "%a "_v);
+        assert(F::segment<1>() == " b%"_v);
+        assert(F::segment<2>() == ""_v);
+
+        Region(R) {
+            Ints ints{3, 4};
+            assert(format<Mregion<R>>("[%] % %%"_f, ints, -5) ==
+                   format<Mregion<R>>("[%] % %%"_v, ints, -5));
+            assert(format<Mregion<R>>("no arguments"_f) == "no arguments"_v);
+
+            String_Builder<Mregion<R>> b;
+            assert(format_to(b, "% and %"_f, 1.0f, "two"_v) == "1.000000 and two"_v);
+        }
+    }
     return 0;
 }
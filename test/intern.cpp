@@ -0,0 +1,60 @@
+
+#include "test.h"
+
+#include <rpp/thread.h>
+
+i32 main() {
+    Test test{"empty"_v};
+    {
+        Intern::Symbol a = Intern::get("alpha"_v);
+        Intern::Symbol b = Intern::get("beta"_v);
+        assert(a && b);
+        assert(!(a == b));
+        assert(Intern::get("alpha"_v) == a);
+        assert(Intern::get<"alpha">() == a);
+        assert(a.view() == "alpha"_v);
+        assert(*Intern::find("beta"_v) == b);
+        assert(!Intern::find("gamma"_v));
+        assert(!Intern::Symbol{});
+
+        // Symbols outlive the strings they were made from.
+        Intern::Symbol c;
+        {
+            String<> s = "a string that is not a literal"_v.string();
+            c = Intern::get(s.view());
+        }
+        assert(c.view() == "a string that is not a literal"_v);
+
+        Map<Intern::Symbol, u64> map;
+        map.insert(a, 1);
+        map.insert(b, 2);
+        assert(**map.try_get(Intern::get("beta"_v)) == 2);
+    }
+    {
+        // Interning the same strings from several threads agrees on one symbol each, and
+        // survives the table growing underneath lock-free lookups.
+        constexpr u64 N = 2000;
+        Vec<Thread::Future<Vec<Intern::Symbol>>> threads;
+        for(u64 t = 0; t < 4; t++) {
+            threads.push(Thread::spawn([]() {
+                Vec<Intern::Symbol> symbols;
+                Region(R) {
+                    for(u64 i = 0; i < N; i++) {
+                        symbols.push(Intern::get(format<Mregion<R>>("symbol %"_v, i).view()));
+                    }
+                }
+                return symbols;
+            }));
+        }
+        Vec<Vec<Intern::Symbol>> results;
+        for(auto& thread : threads) results.push(thread->block());
+        for(u64 i = 0; i < N; i++) {
+            for(auto& result : results) assert(result[i] == results[0][i]);
+            Region(R) {
+                assert(results[0][i].view() == format<Mregion<R>>("symbol %"_v, i));
+            }
+        }
+        assert(Intern::size() >= N);
+    }
+    return 0;
+}
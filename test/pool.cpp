@@ -3,6 +3,7 @@
 
 #include <rpp/asyncio.h>
 #include <rpp/pool.h>
+#include <rpp/sync.h>
 
 auto lots_of_jobs(Async::Pool<>& pool, u64 depth) -> Async::Task<u64> {
     if(depth == 0) {
@@ -14,6 +15,104 @@ auto lots_of_jobs(Async::Pool<>& pool, u64 depth) -> Async::Task<u64> {
     co_return co_await job0 + co_await job1;
 };
 
+auto lots_of_jobs_when_all(Async::Pool<>& pool, u64 depth) -> Async::Task<u64> {
+    if(depth == 0) {
+        co_return 1;
+    }
+    co_await pool.suspend();
+    auto job0 = lots_of_jobs_when_all(pool, depth - 1);
+    auto job1 = lots_of_jobs_when_all(pool, depth - 1);
+    co_await Async::when_all(job0, job1);
+    co_return co_await job0 + co_await job1;
+};
+
+auto wide_jobs(Async::Pool<>& pool, u64 width) -> Async::Task<u64> {
+    auto job = [](Async::Pool<>& pool, u64 i) -> Async::Task<u64> {
+        co_await pool.suspend();
+        co_return i;
+    };
+    Vec<Async::Task<u64>> jobs(width);
+    for(u64 i = 0; i < width; i++) {
+        jobs.push(job(pool, i));
+    }
+    co_await Async::when_all(jobs);
+    u64 sum = 0;
+    for(auto& job : jobs) {
+        assert(job.done());
+        sum += co_await job;
+    }
+    co_return sum;
+};
+
+auto bulk_job(Async::Pool<>& pool, Thread::Atomic<i64>& done) -> Async::Task<void> {
+    co_await pool.suspend(Thread::Priority::high);
+    done.incr();
+}
+
+enum class Wake : u8 { suspend, event, latch };
+
+auto urgent_job(Async::Pool<>& pool, Wake wake, Async::Event& event, Async::Latch<>& latch,
+                Thread::Atomic<i64>& done) -> Async::Task<i64> {
+    if(wake == Wake::event) {
+        co_await pool.wait(event, Thread::Priority::critical);
+    } else if(wake == Wake::latch) {
+        co_await latch.wait(pool, Thread::Priority::critical);
+    } else {
+        co_await pool.suspend(Thread::Priority::critical);
+    }
+    co_return done.load();
+}
+
+// Queues high priority work behind a critical job, then returns how many of the high priority
+// jobs ran before it. The critical job either suspends directly or waits on an event or latch
+// that is released after the high priority work was queued.
+auto preempt(Async::Pool<>& pool, Wake wake) -> Async::Task<i64> {
+    co_await pool.suspend();
+
+    Thread::Atomic<i64> done;
+    Async::Event event;
+    Async::Latch latch{1};
+    Async::Task<i64> urgent;
+    if(wake != Wake::suspend) urgent = urgent_job(pool, wake, event, latch, done);
+
+    Vec<Async::Task<void>> jobs;
+    for(u64 i = 0; i < 100; i++) {
+        jobs.push(bulk_job(pool, done));
+    }
+    if(wake == Wake::event) {
+        event.signal();
+    } else if(wake == Wake::latch) {
+        latch.count_down();
+    } else {
+        urgent = urgent_job(pool, wake, event, latch, done);
+    }
+
+    for(auto& job : jobs) {
+        co_await job;
+    }
+    co_return co_await urgent;
+}
+
+// Queues work from inside a job that then blocks its worker until the work is done, so whatever
+// landed behind the blocked job has to be stolen by another worker.
+auto block_until_stolen(Async::Pool<>& pool) -> Async::Task<i64> {
+    co_await pool.suspend();
+
+    Thread::Atomic<i64> done;
+    Vec<Async::Task<void>> jobs;
+    for(u64 i = 0; i < 100; i++) {
+        jobs.push(bulk_job(pool, done));
+    }
+    while(done.load() < 100) {
+        Thread::pause();
+    }
+
+    for(auto& job : jobs) {
+        co_await job;
+    }
+    co_return done.load();
+}
+
 i32 main() {
     Test test{"pool"_v};
     {
@@ -22,6 +121,64 @@ i32 main() {
         for(u64 i = 0; i < 10; i++) {
             assert(lots_of_jobs(pool, 8).block() == 256);
         }
+        for(u64 i = 0; i < 10; i++) {
+            assert(lots_of_jobs_when_all(pool, 8).block() == 256);
+        }
+        for(u64 i = 0; i < 10; i++) {
+            assert(wide_jobs(pool, 1000).block() == 499500);
+        }
+    }
+    {
+        Async::Pool pool{Async::Placement::physical_first, 0, Async::Idle::park};
+
+        for(u64 i = 0; i < 10; i++) {
+            assert(lots_of_jobs(pool, 8).block() == 256);
+        }
+        for(u64 i = 0; i < 10; i++) {
+            assert(wide_jobs(pool, 1000).block() == 499500);
+        }
+    }
+    {
+        Async::Pool pool;
+        {
+            auto job = [&pool_ = pool](i32 ms) -> Async::Task<i32> {
+                auto& pool = pool_;
+                co_await pool.suspend();
+                if(ms > 0) co_await Async::wait(pool, ms);
+                co_return ms;
+            };
+            auto race = [&job_ = job]() -> Async::Task<i32> {
+                auto& job = job_;
+                auto slow = job(100);
+                auto fast = job(0);
+                u64 first = co_await Async::when_any(slow, fast);
+                assert(first == 1);
+                co_return co_await fast + co_await slow;
+            };
+            assert(race().block() == 100);
+        }
+    }
+    {
+        // With a single worker, nothing else runs until the driver suspends, so the ordering
+        // of the queued jobs is deterministic.
+        auto cpus = Thread::topology();
+        Array<u64, 1> cpuset{cpus[0].id};
+        Async::Pool pool{Slice<u64>{cpuset}};
+
+        for(u64 i = 0; i < 10; i++) {
+            assert(preempt(pool, Wake::suspend).block() == 0);
+            assert(preempt(pool, Wake::event).block() == 0);
+            assert(preempt(pool, Wake::latch).block() == 0);
+        }
+    }
+    {
+        auto cpus = Thread::topology();
+        Array<u64, 2> cpuset{cpus[0].id, cpus[0].id};
+        Async::Pool pool{Slice<u64>{cpuset}};
+
+        for(u64 i = 0; i < 10; i++) {
+            assert(block_until_stolen(pool).block() == 100);
+        }
     }
     {
         Async::Pool pool;
@@ -141,5 +298,111 @@ i32 main() {
             info("Waited 100ms.");
         }
     }
+    {
+        Async::Pool pool;
+
+        // Parks coroutines on the calling thread so they can be resumed in one batch.
+        struct Park {
+            Vec<Async::Handle<>>& parked;
+
+            [[nodiscard]] bool await_ready() noexcept {
+                return false;
+            }
+            void await_suspend(std::coroutine_handle<> handle) noexcept {
+                parked.push(Async::Handle<>{handle});
+            }
+            void await_resume() noexcept {
+            }
+        };
+        auto job = [](Vec<Async::Handle<>>& parked,
+                      Thread::Atomic<i64>& done) -> Async::Task<void> {
+            co_await Park{parked};
+            done.incr();
+        };
+
+        for(u64 n : {1, 3, 1000}) {
+            Vec<Async::Handle<>> parked;
+            Thread::Atomic<i64> done;
+            Vec<Async::Task<void>> jobs;
+            for(u64 i = 0; i < n; i++) {
+                jobs.push(job(parked, done));
+            }
+            assert(parked.length() == n && done.load() == 0);
+            pool.enqueue_batch(Slice<Async::Handle<>>{parked}, Async::Priority::high);
+            for(auto& job : jobs) {
+                job.block();
+            }
+            assert(static_cast<u64>(done.load()) == n);
+        }
+        pool.enqueue_batch(Slice<Async::Handle<>>{});
+    }
+    {
+        Async::Pool pool;
+        Async::Event event;
+        Thread::Atomic<i64> woken;
+        assert(!event.is_sys());
+
+        auto job = [](Async::Pool<>& pool, Async::Event& event,
+                      Thread::Atomic<i64>& woken) -> Async::Task<void> {
+            co_await pool.suspend();
+            co_await pool.wait(event);
+            woken.incr();
+        };
+
+        // More waiters than fit in one wakeup batch.
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 200; i++) {
+            jobs.push(job(pool, event, woken));
+        }
+        assert(!event.try_wait());
+        event.signal();
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(woken.load() == 200);
+        assert(event.try_wait());
+
+        // Already signalled, so this completes without suspending.
+        job(pool, event, woken).block();
+        assert(woken.load() == 201);
+
+        event.reset();
+        assert(!event.try_wait());
+
+        Async::Event sys = Async::Event::make_sys();
+        assert(sys.is_sys());
+        assert(!sys.try_wait());
+        sys.signal();
+        assert(sys.try_wait());
+        sys.reset();
+        assert(!sys.try_wait());
+    }
+    {
+        auto cpus = Thread::topology();
+        assert(cpus.length() > 0);
+
+        Array<u64, 1> cpuset{cpus[0].id};
+        Async::Pool pinned{Slice<u64>{cpuset}};
+        Async::Pool local{Async::Placement::numa_local, cpus[0].node};
+        assert(pinned.n_threads() == 1);
+        assert(local.n_threads() > 0);
+
+        auto job = [](Async::Pool<>& pool, Async::Pool<>& other) -> Async::Task<u64> {
+            u64 sum = 0;
+            for(u64 i = 0; i < 100; i++) {
+                co_await (i % 2 ? pool.suspend() : other.suspend());
+                sum += i;
+            }
+            co_return sum;
+        };
+
+        Vec<Async::Task<u64>> jobs;
+        for(u64 i = 0; i < 16; i++) {
+            jobs.push(job(pinned, local));
+        }
+        for(auto& job : jobs) {
+            assert(job.block() == 4950);
+        }
+    }
     return 0;
 }
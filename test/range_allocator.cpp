@@ -2,6 +2,7 @@
 #include "test.h"
 
 #include <rpp/range_allocator.h>
+#include <rpp/thread.h>
 
 i32 main() {
     Test test{"empty"_v};
@@ -27,5 +28,189 @@ i32 main() {
         }
         allocator.statistics().assert_clear();
     }
+    {
+        // Fragment the heap with alternating holes, then fill them exactly.
+        Range_Allocator small(Math::MB(1));
+        Vec<Range_Allocator<>::Range> ranges;
+        for(u64 i = 0; i < 1024; i++) {
+            ranges.push(*small.allocate(1024, 16));
+        }
+        assert(!small.allocate(1, 1));
+        for(u64 i = 0; i < 1024; i += 2) {
+            small.free(ranges[i]);
+        }
+        assert(!small.allocate(2048, 1));
+        for(u64 i = 0; i < 1024; i += 2) {
+            ranges[i] = *small.allocate(1024, 16);
+        }
+        for(auto& range : ranges) {
+            small.free(range);
+        }
+        small.statistics().assert_clear();
+        assert(small.allocate(Math::MB(1), 1));
+    }
+    for(u64 i = 0; i < 100; i++) {
+        Region(R) {
+            Vec<Range_Allocator<>::Range, Mregion<R>> allocations(1000);
+            for(u64 j = 0; j < 1000; j++) {
+                u64 align = static_cast<u64>(1)
+                            << rng.range(static_cast<u64>(0), static_cast<u64>(8));
+                u64 size = rng.range(static_cast<u64>(1), Math::KB(64));
+                auto mem = *allocator.allocate(size, align);
+                assert(mem->offset % align == 0);
+                allocations.push(mem);
+                if(rng.coin_flip(0.5f)) {
+                    u64 idx = rng.range(static_cast<u64>(0), allocations.length());
+                    allocator.free(allocations[idx]);
+                    allocations[idx] = allocations.back();
+                    allocations.pop();
+                }
+            }
+            for(auto& mem : allocations) {
+                allocator.free(mem);
+            }
+        }
+        allocator.statistics().assert_clear();
+    }
+    {
+        // Fragment a heap with real backing memory, then compact it in small slices.
+        constexpr u64 heap_size = Math::KB(256);
+        Range_Allocator heap(heap_size);
+        Vec<u8> memory(heap_size);
+        memory.resize(heap_size);
+
+        struct Live {
+            Range_Allocator<>::Range range;
+            u64 alignment;
+            u8 tag;
+        };
+        Vec<Live> live;
+
+        for(u64 i = 0; i < 512; i++) {
+            u64 align = static_cast<u64>(1) << rng.range(static_cast<u64>(0), static_cast<u64>(7));
+            u64 size = rng.range(static_cast<u64>(1), static_cast<u64>(256));
+            auto range = *heap.allocate(size, align);
+            u8 tag = static_cast<u8>(i);
+            Libc::memset(memory.data() + range->offset, tag, size);
+            live.push(Live{range, align, tag});
+        }
+        // Free every other range, leaving holes between the survivors.
+        u64 kept = 0;
+        for(u64 i = 0; i < live.length(); i++) {
+            if(i % 2) {
+                heap.free(live[i].range);
+            } else {
+                live[kept++] = live[i];
+            }
+        }
+        while(live.length() > kept) live.pop();
+
+        auto before = heap.statistics();
+        assert(before.fragmentation() > 0.0);
+
+        u64 slices = 0;
+        auto relocate = [&](Range_Allocator<>::Range range, u64 from) {
+            Libc::memmove(memory.data() + range->offset, memory.data() + from, range->length());
+        };
+        while(!heap.defragment(relocate, 8)) {
+            slices++;
+        }
+        assert(slices > 1);
+
+        auto after = heap.statistics();
+        assert(after.free_blocks <= 1);
+        assert(after.fragmentation() == 0.0);
+        assert(after.total_relocations > 0);
+
+        for(auto& l : live) {
+            assert(l.range->offset % l.alignment == 0);
+            for(u64 i = 0; i < l.range->length(); i++) {
+                assert(memory[l.range->offset + i] == l.tag);
+            }
+        }
+
+        // All free space is contiguous again.
+        auto rest = heap.allocate(after.free_size, 1);
+        assert(rest);
+        heap.free(*rest);
+
+        for(auto& l : live) {
+            heap.free(l.range);
+        }
+        heap.statistics().assert_clear();
+    }
+    {
+        // Freeing the range in front of the cursor's hole merges the hole away.
+        Range_Allocator heap(Math::KB(1));
+        auto a = *heap.allocate(16, 1);
+        auto b = *heap.allocate(16, 1);
+        auto c = *heap.allocate(16, 1);
+        auto relocate = [](Range_Allocator<>::Range, u64) {};
+
+        heap.free(a);
+        assert(!heap.defragment(relocate, 1));
+        assert(b->offset == 0);
+        heap.free(b);
+
+        auto d = *heap.allocate(16, 1);
+        while(!heap.defragment(relocate, 1)) {
+        }
+        assert(heap.statistics().free_blocks == 1);
+        heap.free(c);
+        heap.free(d);
+        heap.statistics().assert_clear();
+    }
+    {
+        Concurrent_Range_Allocator<> concurrent(Math::GB(1), Math::MB(16), 4);
+
+        constexpr u64 threads = 4;
+        Array<Vec<Concurrent_Range_Allocator<>::Range>, threads> kept;
+
+        Vec<Thread::Future<void>> tasks;
+        for(u64 i = 0; i < threads; i++) {
+            tasks.push(Thread::spawn([&, i]() {
+                RNG::Stream rng(i + 1);
+                Vec<Concurrent_Range_Allocator<>::Range> live;
+                for(u64 j = 0; j < 10000; j++) {
+                    u64 align = static_cast<u64>(1)
+                            << rng.range(static_cast<u64>(0), static_cast<u64>(8));
+                    u64 size = rng.range(static_cast<u64>(1), Math::KB(16));
+                    auto mem = *concurrent.allocate(size, align);
+                    assert(mem->offset % align == 0);
+                    live.push(mem);
+                    if(rng.coin_flip(0.5f)) {
+                        u64 idx = rng.range(static_cast<u64>(0), live.length());
+                        concurrent.free(live[idx]);
+                        live[idx] = live.back();
+                        live.pop();
+                    }
+                }
+                kept[i] = move(live);
+            }));
+        }
+        for(auto& task : tasks) {
+            task->block();
+        }
+
+        // Free each thread's survivors from another thread to exercise remote frees.
+        tasks.clear();
+        for(u64 i = 0; i < threads; i++) {
+            tasks.push(Thread::spawn([&, i]() {
+                for(auto& mem : kept[(i + 1) % threads]) {
+                    concurrent.free(mem);
+                }
+            }));
+        }
+        for(auto& task : tasks) {
+            task->block();
+        }
+
+        // Larger than a chunk, so served by the shared heap.
+        auto large = *concurrent.allocate(Math::MB(32), 64);
+        concurrent.free(large);
+
+        concurrent.trim();
+        concurrent.statistics().assert_clear();
+    }
     return 0;
 }
@@ -0,0 +1,136 @@
+
+#include "test.h"
+
+#include <rpp/serialize.h>
+
+enum class Shape : u8 {
+    circle,
+    square,
+};
+
+struct Point {
+    f32 x;
+    f32 y;
+};
+
+struct Padded {
+    u8 a;
+    u64 b;
+};
+
+struct Save {
+    String<> name;
+    Vec<Point> points;
+    Map<String<>, i32> scores;
+    Opt<Shape> shape;
+    Variant<i32, String<>> tag{0};
+    Array<i16, 3> triple;
+    Box<Padded> padded;
+    bool flag = false;
+};
+
+struct Save_View {
+    String_View name;
+    Slice<Point> points;
+};
+
+struct Save_Header {
+    String<> name;
+    Vec<Point> points;
+};
+
+RPP_ENUM(Shape, circle, RPP_CASE(circle), RPP_CASE(square));
+RPP_RECORD(Point, RPP_FIELD(x), RPP_FIELD(y));
+RPP_RECORD(Padded, RPP_FIELD(a), RPP_FIELD(b));
+RPP_RECORD(Save, RPP_FIELD(name), RPP_FIELD(points), RPP_FIELD(scores), RPP_FIELD(shape),
+           RPP_FIELD(tag), RPP_FIELD(triple), RPP_FIELD(padded), RPP_FIELD(flag));
+RPP_RECORD(Save_View, RPP_FIELD(name), RPP_FIELD(points));
+RPP_RECORD(Save_Header, RPP_FIELD(name), RPP_FIELD(points));
+
+i32 main() {
+    Test test{"empty"_v};
+    {
+        static_assert(Serialize::Packed<i32>);
+        static_assert(Serialize::Packed<Shape>);
+        static_assert(Serialize::Packed<Point>);
+        static_assert(Serialize::Packed<Array<Point, 4>>);
+        static_assert(!Serialize::Packed<bool>);
+        static_assert(!Serialize::Packed<Padded>);
+        static_assert(!Serialize::Packed<Save>);
+        static_assert(Serialize::Codec<Save_View>::schema == Serialize::Codec<Save_Header>::schema);
+        static_assert(Serialize::Codec<Save>::schema != Serialize::Codec<Save_Header>::schema);
+    }
+    {
+        Save save;
+        save.name = "a name longer than the inline capacity"_v.string();
+        save.points.push(Point{1.0f, 2.0f});
+        save.points.push(Point{3.0f, 4.0f});
+        save.scores.insert("one"_v.string(), 1);
+        save.scores.insert("two"_v.string(), 2);
+        save.shape = Shape::square;
+        save.tag = Variant<i32, String<>>{"tag"_v.string()};
+        save.triple = Array<i16, 3>{i16{1}, i16{-2}, i16{3}};
+        save.padded = Box<Padded>{Padded{7, 8}};
+        save.flag = true;
+
+        Vec<u8> bytes = Serialize::write(save);
+        Opt<Save> read = Serialize::read<Save>(bytes.slice());
+        assert(read);
+        assert(read->name == save.name);
+        assert(read->points.length() == 2);
+        assert(read->points[1].x == 3.0f && read->points[1].y == 4.0f);
+        assert(read->scores.length() == 2);
+        assert(read->scores.get("two"_v) == 2);
+        assert(*read->shape == Shape::square);
+        assert((read->tag.match(Overload{[](i32) { return false; },
+                                         [](const String<>& s) { return s == "tag"_v; }})));
+        assert(read->triple[1] == -2);
+        assert(read->padded->a == 7 && read->padded->b == 8);
+        assert(read->flag);
+
+        // Records with the same field names read the same bytes, so a view can skip copying.
+        Vec<u8> header =
+            Serialize::write(Save_Header{"header"_v.string(), Vec<Point>{Point{5.0f, 6.0f}}});
+        Opt<Save_View> in_place = Serialize::read<Save_View>(header.slice());
+        assert(in_place);
+        assert(in_place->name == "header"_v);
+        assert(in_place->name.data() > header.data());
+        assert(in_place->points.length() == 1 && in_place->points[0].y == 6.0f);
+
+        // Mismatched schemas, truncation, and trailing bytes are rejected.
+        assert(!Serialize::read<Save_Header>(bytes.slice()));
+        assert(!Serialize::read<Save>(Slice<u8>{bytes.data(), bytes.length() - 1}));
+        bytes.push(0);
+        assert(!Serialize::read<Save>(bytes.slice()));
+    }
+    {
+        Array<Point, 4> points{Point{1.0f, 2.0f}, Point{3.0f, 4.0f}, Point{5.0f, 6.0f},
+                               Point{7.0f, 8.0f}};
+        Vec<u8> bytes = Serialize::write(points);
+        assert(bytes.length() == sizeof(u64) + sizeof(points));
+
+        Opt<Ref<const Array<Point, 4>>> view = Serialize::view<Array<Point, 4>>(bytes.slice());
+        assert(view);
+        assert((**view)[3].x == 7.0f);
+        assert(reinterpret_cast<const u8*>(&**view) == bytes.data() + sizeof(u64));
+    }
+    {
+        using Items = Vec<Variant<Opt<i32>, String_View>>;
+        Items items;
+        items.push(Variant<Opt<i32>, String_View>{Opt<i32>{3}});
+        items.push(Variant<Opt<i32>, String_View>{"view"_v});
+        items.push(Variant<Opt<i32>, String_View>{Opt<i32>{}});
+
+        Vec<u8> bytes = Serialize::write(items);
+        Opt<Items> read = Serialize::read<Items>(bytes.slice());
+        assert(read && read->length() == 3);
+        assert((*read)[0].index() == 0 && (*read)[1].index() == 1 && (*read)[2].index() == 0);
+        assert(((*read)[1].match(Overload{[](const Opt<i32>&) { return false; },
+                                          [](String_View s) { return s == "view"_v; }})));
+
+        // A corrupt tag is rejected.
+        bytes[sizeof(u64) * 2] = 9;
+        assert(!Serialize::read<Items>(bytes.slice()));
+    }
+    return 0;
+}
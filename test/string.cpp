@@ -29,6 +29,121 @@ i32 main() {
         (void)s4;
         (void)sv4;
     }
+    Trace("Inline") {
+        static_assert(sizeof(String<>) == 24);
+
+        String s = "short"_v.string();
+        assert(s.is_inline());
+        String s2 = move(s);
+        assert(s2.is_inline() && s2 == "short"_v);
+        assert(s.empty());
+
+        String l = "a string too long to be stored inline"_v.string();
+        assert(!l.is_inline());
+        const u8* data = l.data();
+        String l2 = move(l);
+        assert(l2.data() == data);
+
+        s2 = move(l2);
+        assert(!s2.is_inline() && s2 == "a string too long to be stored inline"_v);
+        l2 = "abc"_v.string();
+        s2 = move(l2);
+        assert(s2.is_inline() && s2 == "abc"_v);
+
+        String<Mdefault> c = s2.clone();
+        assert(c.is_inline() && c == "abc"_v);
+
+        String t = "0123456789abcdef"_v.terminate<Mdefault>();
+        assert(!t.is_inline() && t.length() == 17);
+    }
+    Trace("Hash") {
+        constexpr u64 literal = Hash::bytes("Hello World", 11);
+        static_assert(literal == hash_literal("Hello World"));
+        assert(hash("Hello World"_v) == literal);
+        assert(hash("Hello World"_v.string()) == literal);
+
+        // Every length through each tail and block path.
+        Region(R) {
+            Vec<u8, Mregion<R>> buffer;
+            for(u64 i = 0; i < 200; i++) buffer.push(static_cast<u8>('a' + i % 26));
+            Map<u64, u64, Mregion<R>> seen;
+            for(u64 length = 0; length <= 200; length++) {
+                String_View view{buffer.data(), length};
+                u64 h = hash(view);
+                assert(h == hash(view.string<Mregion<R>>()));
+                assert(!seen.contains(h));
+                seen.insert(h, length);
+            }
+        }
+
+        Map<String<>, u64> map;
+        for(u64 i = 0; i < 1000; i++) {
+            map.insert(format<Mdefault>("key%"_v, i), i);
+        }
+        for(u64 i = 0; i < 1000; i++) {
+            assert(**map.try_get(format<Mdefault>("key%"_v, i)) == i);
+        }
+    }
+    Trace("Search") {
+        String_View text = "The quick brown fox jumps over the lazy dog, then the fox naps."_v;
+        assert(*text.find('q') == 4);
+        assert(*text.find('.') == text.length() - 1);
+        assert(!text.find('!'));
+        assert(*text.find("fox"_v) == 16);
+        assert(*text.find("fox naps"_v) == 54);
+        assert(*text.find("naps."_v) == 58);
+        assert(!text.find("cat"_v));
+        assert(*text.find(""_v) == 0);
+        assert(*text.find_any(",."_v) == 43);
+        assert(*text.find_any("0123456789zyx"_v) == 18);
+        assert(!text.find_any("!?"_v));
+        assert(text.count('o') == 5);
+        assert(text.count('!') == 0);
+
+        // Matches in the block tail and straddling block boundaries.
+        Region(R) {
+            for(u64 length = 1; length < 100; length++) {
+                String<Mregion<R>> s{length};
+                s.set_length(length);
+                for(u8& c : s) c = '.';
+                s[length - 1] = 'x';
+                assert(*s.view().find('x') == length - 1);
+                assert(*s.view().find_any("xyz"_v) == length - 1);
+                assert(s.view().count('.') == length - 1);
+                if(length >= 2) {
+                    s[length - 2] = 'w';
+                    assert(*s.view().find("wx"_v) == length - 2);
+                }
+            }
+        }
+
+        u64 n = 0;
+        Array<String_View, 4> fields{"a"_v, ""_v, "bc"_v, ""_v};
+        for(String_View field : "a,,bc,"_v.split(',')) {
+            assert(field == fields[n++]);
+        }
+        assert(n == 4);
+
+        n = 0;
+        Array<String_View, 3> lines{"one"_v, ""_v, "three"_v};
+        for(String_View line : "one\r\n\nthree\n"_v.lines()) {
+            assert(line == lines[n++]);
+        }
+        assert(n == 3);
+
+        n = 0;
+        for(String_View line : ""_v.lines()) {
+            (void)line;
+            n++;
+        }
+        assert(n == 0);
+
+        String upper = "Hello, World! Mixed CASE text that spans a full block."_v.string();
+        upper.to_uppercase();
+        assert(upper == "HELLO, WORLD! MIXED CASE TEXT THAT SPANS A FULL BLOCK."_v);
+        upper.to_lowercase();
+        assert(upper == "hello, world! mixed case text that spans a full block."_v);
+    }
 
     return 0;
 }
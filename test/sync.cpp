@@ -0,0 +1,179 @@
+
+#include "test.h"
+
+#include <rpp/pool.h>
+#include <rpp/sync.h>
+
+i32 main() {
+    Test test{"empty"_v};
+    {
+        Async::Pool pool;
+        Async::Mutex mutex;
+        u64 counter = 0;
+
+        auto job = [](Async::Pool<>& pool, Async::Mutex<>& mutex,
+                      u64& counter) -> Async::Task<void> {
+            for(u64 i = 0; i < 100; i++) {
+                co_await pool.suspend();
+                co_await mutex.lock(pool);
+                u64 value = counter;
+                co_await pool.suspend();
+                counter = value + 1;
+                mutex.unlock();
+            }
+        };
+
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 16; i++) {
+            jobs.push(job(pool, mutex, counter));
+        }
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(counter == 1600);
+        assert(mutex.try_lock());
+        mutex.unlock();
+    }
+    {
+        Async::Pool pool;
+        Async::Semaphore semaphore{2};
+        Thread::Atomic<i64> holders;
+
+        auto job = [](Async::Pool<>& pool, Async::Semaphore<>& semaphore,
+                      Thread::Atomic<i64>& holders) -> Async::Task<void> {
+            for(u64 i = 0; i < 100; i++) {
+                co_await pool.suspend();
+                co_await semaphore.acquire(pool);
+                assert(holders.incr() <= 2);
+                co_await pool.suspend();
+                holders.decr();
+                semaphore.release();
+            }
+        };
+
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 16; i++) {
+            jobs.push(job(pool, semaphore, holders));
+        }
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(semaphore.try_acquire());
+        assert(semaphore.try_acquire());
+        assert(!semaphore.try_acquire());
+    }
+    {
+        Async::Pool pool;
+        Async::Semaphore semaphore{0};
+        Thread::Mutex lock;
+        Vec<u64> order;
+
+        auto job = [](Async::Pool<>& pool, Async::Semaphore<>& semaphore, Thread::Mutex& lock,
+                      Vec<u64>& order, u64 i, bool pass) -> Async::Task<void> {
+            co_await semaphore.acquire(pool);
+            {
+                Thread::Lock guard(lock);
+                order.push(i);
+            }
+            if(pass) semaphore.release();
+        };
+
+        // A released permit goes to the queued waiter, not to a later try_acquire.
+        auto first = job(pool, semaphore, lock, order, 0, false);
+        semaphore.release();
+        assert(!semaphore.try_acquire());
+        first.block();
+        order.clear();
+
+        // Each job is created on this thread and queues before the next one starts. Every
+        // permit is passed along the queue, so the jobs must run in arrival order.
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 100; i++) {
+            jobs.push(job(pool, semaphore, lock, order, i, true));
+        }
+        semaphore.release();
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(order.length() == 100);
+        for(u64 i = 0; i < 100; i++) {
+            assert(order[i] == i);
+        }
+        assert(semaphore.try_acquire());
+        assert(!semaphore.try_acquire());
+    }
+    {
+        Async::Pool pool;
+        Async::Latch latch{8};
+        Thread::Atomic<i64> woken;
+
+        auto job = [](Async::Pool<>& pool, Async::Latch<>& latch,
+                      Thread::Atomic<i64>& woken) -> Async::Task<void> {
+            co_await pool.suspend();
+            co_await latch.wait(pool);
+            woken.incr();
+        };
+
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 16; i++) {
+            jobs.push(job(pool, latch, woken));
+        }
+        for(u64 i = 0; i < 8; i++) {
+            assert(woken.load() == 0);
+            latch.count_down();
+        }
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(latch.try_wait());
+        assert(woken.load() == 16);
+    }
+    {
+        Async::Pool pool;
+        Async::Latch latch{1};
+        Thread::Atomic<i64> woken;
+
+        auto job = [](Async::Pool<>& pool, Async::Latch<>& latch,
+                      Thread::Atomic<i64>& woken) -> Async::Task<void> {
+            co_await pool.suspend();
+            co_await latch.wait(pool);
+            woken.incr();
+        };
+
+        // More waiters than fit in one wakeup batch.
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 200; i++) {
+            jobs.push(job(pool, latch, woken));
+        }
+        latch.count_down();
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(woken.load() == 200);
+    }
+    {
+        Async::Pool pool;
+        Async::Barrier barrier{8};
+        Thread::Atomic<i64> arrived;
+
+        auto job = [](Async::Pool<>& pool, Async::Barrier<>& barrier,
+                      Thread::Atomic<i64>& arrived) -> Async::Task<void> {
+            for(i64 phase = 0; phase < 10; phase++) {
+                co_await pool.suspend();
+                arrived.incr();
+                co_await barrier.arrive_and_wait(pool);
+                assert(arrived.load() >= (phase + 1) * 8);
+            }
+        };
+
+        Vec<Async::Task<void>> jobs;
+        for(u64 i = 0; i < 8; i++) {
+            jobs.push(job(pool, barrier, arrived));
+        }
+        for(auto& job : jobs) {
+            job.block();
+        }
+        assert(barrier.phase() == 10);
+    }
+    return 0;
+}
@@ -11,6 +11,53 @@ i32 main() {
         mut.unlock();
         { Thread::Lock lock{mut}; }
     }
+    Trace("Mutex") {
+        static_assert(sizeof(Thread::Mutex) == 4);
+
+        Thread::Mutex mut;
+        assert(mut.try_lock());
+        assert(!mut.try_lock());
+        mut.unlock();
+
+        u64 counter = 0;
+        Vec<Thread::Future<void>> tasks;
+        for(u64 i = 0; i < 4; i++) {
+            tasks.push(Thread::spawn([&]() {
+                for(u64 j = 0; j < 10000; j++) {
+                    Thread::Lock lock{mut};
+                    counter++;
+                }
+            }));
+        }
+        for(auto& task : tasks) {
+            task->block();
+        }
+        assert(counter == 40000);
+    }
+    Trace("Cond") {
+        Thread::Mutex mut;
+        Thread::Cond cond;
+        u64 turn = 0;
+
+        auto odd = Thread::spawn([&]() {
+            Thread::Lock lock{mut};
+            for(u64 i = 1; i < 200; i += 2) {
+                while(turn != i) cond.wait(mut);
+                turn++;
+                cond.broadcast();
+            }
+        });
+        {
+            Thread::Lock lock{mut};
+            for(u64 i = 0; i < 200; i += 2) {
+                while(turn != i) cond.wait(mut);
+                turn++;
+                cond.signal();
+            }
+        }
+        odd->block();
+        assert(turn == 200);
+    }
     Trace("Spawn") {
         auto value = Thread::spawn([]() { return Vec<i32>{2, 3}; });
 
@@ -35,5 +82,121 @@ i32 main() {
             task->block();
         }
     }
+    Trace("Atomics") {
+        Thread::Atomic<u32> bits;
+        assert(bits.fetch_or(0b101, Thread::Order::relaxed) == 0);
+        assert(bits.fetch_and(0b100, Thread::Order::acq_rel) == 0b101);
+        assert(bits.fetch_xor(0b110) == 0b100);
+        assert(bits.fetch_add(1, Thread::Order::release) == 0b010);
+        assert(bits.load(Thread::Order::acquire) == 0b011);
+
+        i32 value = 0;
+        Thread::Atomic<i32*> pointer;
+        assert(pointer.compare_and_swap(null, &value, Thread::Order::acq_rel) == null);
+        assert(pointer.exchange(null) == &value);
+
+        Thread::Atomic<bool> flag;
+        flag.store(true, Thread::Order::release);
+        assert(flag.load(Thread::Order::acquire));
+
+        Thread::Atomic<i32> turn;
+        auto ping = Thread::spawn([&turn]() {
+            for(i32 i = 0; i < 50; i++) {
+                while(turn.load(Thread::Order::acquire) != 2 * i + 1) turn.wait(2 * i);
+                turn.store(2 * i + 2, Thread::Order::release);
+                turn.notify_one();
+            }
+        });
+        for(i32 i = 0; i < 50; i++) {
+            turn.store(2 * i + 1, Thread::Order::release);
+            turn.notify_one();
+            while(turn.load(Thread::Order::acquire) != 2 * i + 2) turn.wait(2 * i + 1);
+        }
+        ping->block();
+    }
+    Trace("Flags") {
+        Thread::Flag early;
+        early.signal();
+        assert(early.ready());
+        early.block();
+
+        Thread::Flag late;
+        auto waiter = Thread::spawn([&late]() { late.block(); });
+        Thread::sleep(10);
+        assert(!late.ready());
+        late.signal();
+        waiter->block();
+        assert(late.ready());
+    }
+    Trace("RwLock") {
+        Thread::RwLock lock;
+        i64 a = 0, b = 0;
+
+        Vec<Thread::Future<void>> tasks;
+        for(u64 i = 0; i < 4; i++) {
+            tasks.push(Thread::spawn([&]() {
+                for(u64 j = 0; j < 1000; j++) {
+                    Thread::Write_Lock write{lock};
+                    a++;
+                    b--;
+                }
+            }));
+            tasks.push(Thread::spawn([&]() {
+                for(u64 j = 0; j < 1000; j++) {
+                    Thread::Read_Lock read{lock};
+                    assert(a == -b);
+                }
+            }));
+        }
+        for(auto& task : tasks) {
+            task->block();
+        }
+        assert(a == 4000 && b == -4000);
+
+        assert(lock.try_lock_shared());
+        assert(lock.try_lock_shared());
+        assert(!lock.try_lock());
+        lock.unlock_shared();
+        lock.unlock_shared();
+        assert(lock.try_lock());
+        assert(!lock.try_lock_shared());
+        lock.unlock();
+
+        // Writers that all block at once must each be woken in turn.
+        Thread::Atomic<u64> acquired;
+        lock.lock();
+        Vec<Thread::Future<void>> writers;
+        for(u64 i = 0; i < 4; i++) {
+            writers.push(Thread::spawn([&]() {
+                Thread::Write_Lock write{lock};
+                acquired.incr();
+            }));
+        }
+        Thread::sleep(10);
+        assert(acquired.load() == 0);
+        lock.unlock();
+        for(auto& writer : writers) {
+            writer->block();
+        }
+        assert(acquired.load() == 4);
+    }
+    Trace("Seqlock") {
+        struct Snapshot {
+            u64 a = 0, b = 0;
+        };
+        Thread::Seqlock<Snapshot> seqlock;
+
+        auto writer = Thread::spawn([&seqlock]() {
+            for(u64 i = 1; i <= 10000; i++) {
+                seqlock.write(Snapshot{i, i * 2});
+            }
+        });
+        for(u64 i = 0; i < 10000; i++) {
+            Snapshot snapshot = seqlock.read();
+            assert(snapshot.b == snapshot.a * 2);
+        }
+        writer->block();
+        assert(seqlock.read().a == 10000);
+    }
     return 0;
 }